@@ -0,0 +1,76 @@
+#include "allocation_replay.hpp"
+#include "allocation_tracker.hpp"
+#include "generator.hpp"
+#include "item.hpp"
+#include "async_log.hpp"
+
+namespace {
+
+constexpr int bot_direction_ticks{ ticks_per_second };
+constexpr int bot_attack_ticks{ ticks_per_second / 3 };
+
+// Walks in a square, so the bot stays near where it started and keeps fighting.
+constexpr int bot_directions[]{ 1, 3, 0, 2 };
+
+}
+
+allocation_replay::allocation_replay() : world{ std::make_unique<game_world>() }, generator{ std::make_unique<game_world_generator>() } {
+
+}
+
+allocation_replay::~allocation_replay() = default;
+
+long long allocation_replay::run(int frames) {
+	// The same seed gives the same dungeon and monsters on every run.
+	world->random = no::random_number_generator{ 45 };
+	generator->set_seed(45);
+	generator->generate_dungeon(*world, 'f');
+	world->place_player();
+	world->add_monsters();
+	// A staff, so the replay also covers projectiles.
+	world->player.give_item(item_type::fire_staff, -1);
+	ticks = 0;
+	long long over_budget_frames{ 0 };
+	LOG_INFO(log_category::performance, "Allocation replay started for %i frames", frames);
+	for (int frame{ -warm_up_frames }; frame < frames; frame++) {
+		update_bot();
+		{
+			allocation_scope scope{ allocation_subsystem::world };
+			world->update();
+		}
+		// The events are only presented by the game, so they are dropped here.
+		world->events.clear();
+		allocation_tracker::next_frame();
+		if (frame >= 0 && check_last_frame(frame)) {
+			over_budget_frames++;
+		}
+		ticks++;
+	}
+	LOG_INFO(log_category::performance, "Allocation replay finished with %lld of %i frames over budget", over_budget_frames, frames);
+	return over_budget_frames;
+}
+
+bool allocation_replay::check_last_frame(int frame) const {
+	bool over_budget{ false };
+	for (int subsystem{ 0 }; subsystem < allocation_subsystem::total_subsystems; subsystem++) {
+		const long long budget{ allocation_tracker::budget(subsystem) };
+		if (budget >= 0 && allocation_tracker::last_frame(subsystem).allocations > budget) {
+			over_budget = true;
+		}
+	}
+	if (over_budget) {
+		const auto allocations{ allocation_tracker::last_frame(allocation_subsystem::world) };
+		LOG_WARNING(log_category::performance, "Frame %i over allocation budget. World: %lld allocations, %lld B", frame, allocations.allocations, allocations.bytes);
+	}
+	return over_budget;
+}
+
+void allocation_replay::update_bot() {
+	auto& player{ world->player };
+	player.stats.health = player.final_stats().max_health;
+	const int direction{ bot_directions[(ticks / bot_direction_ticks) % std::size(bot_directions)] };
+	player.move(direction == 0, direction == 1, direction == 2, direction == 3);
+	if (player.room && ticks % bot_attack_ticks == 0) {
+		player.attack();
+	}
+}
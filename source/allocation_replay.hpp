@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+
+class game_world;
+class game_world_generator;
+
+// Plays the same dungeon run with a scripted bot, and counts the steady-state frames that go over the allocation budget.
+// The first frames are not counted, since entering the dungeon allocates the rooms and objects.
+// Runs before the window is opened, so only the world simulation is covered. The renderer and UI are never updated or drawn,
+// and their allocations are only shown by the tracker in the debug menu.
+class allocation_replay {
+public:
+
+	int warm_up_frames{ 120 };
+
+	allocation_replay();
+	allocation_replay(const allocation_replay&) = delete;
+	allocation_replay(allocation_replay&&) = delete;
+	~allocation_replay();
+
+	allocation_replay& operator=(const allocation_replay&) = delete;
+	allocation_replay& operator=(allocation_replay&&) = delete;
+
+	// Returns the number of measured frames that went over budget.
+	long long run(int frames);
+
+private:
+
+	bool check_last_frame(int frame) const;
+	void update_bot();
+
+	std::unique_ptr<game_world> world;
+	std::unique_ptr<game_world_generator> generator;
+	int ticks{ 0 };
+
+};
@@ -0,0 +1,189 @@
+#include "allocation_tracker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+
+thread_local int thread_subsystem{ allocation_subsystem::other };
+
+// Plain atomics, since these may be touched before any constructors run.
+std::atomic<long long> frame_allocations[allocation_subsystem::total_subsystems];
+std::atomic<long long> frame_bytes[allocation_subsystem::total_subsystems];
+allocation_counts finished_frame[allocation_subsystem::total_subsystems];
+long long budgets[allocation_subsystem::total_subsystems]{ -1, 0, 0, 0 };
+long long over_budget_frames{ 0 };
+
+void count_allocation(std::size_t size) {
+	frame_allocations[thread_subsystem].fetch_add(1, std::memory_order_relaxed);
+	frame_bytes[thread_subsystem].fetch_add(static_cast<long long>(size), std::memory_order_relaxed);
+}
+
+#if WITH_ALLOCATION_TRACKING
+
+void* allocate_aligned(std::size_t size, std::align_val_t alignment) {
+	const std::size_t alignment_bytes{ static_cast<std::size_t>(alignment) };
+	// Both require a non-zero size, and aligned_alloc a multiple of the alignment.
+	const std::size_t aligned_size{ (std::max<std::size_t>(size, 1) + alignment_bytes - 1) / alignment_bytes * alignment_bytes };
+#ifdef _WIN32
+	return _aligned_malloc(aligned_size, alignment_bytes);
+#else
+	return std::aligned_alloc(alignment_bytes, aligned_size);
+#endif
+}
+
+void free_aligned(void* pointer) {
+#ifdef _WIN32
+	_aligned_free(pointer);
+#else
+	std::free(pointer);
+#endif
+}
+
+#endif
+
+}
+
+namespace allocation_subsystem {
+
+const char* get_name(int subsystem) {
+	switch (subsystem) {
+	case world: return "World";
+	case renderer: return "Renderer";
+	case ui: return "UI";
+	default: return "Other";
+	}
+}
+
+}
+
+allocation_scope::allocation_scope(int subsystem) : previous_subsystem{ thread_subsystem } {
+	thread_subsystem = subsystem;
+}
+
+allocation_scope::~allocation_scope() {
+	thread_subsystem = previous_subsystem;
+}
+
+namespace allocation_tracker {
+
+void next_frame() {
+	bool over_budget{ false };
+	for (int i{ 0 }; i < allocation_subsystem::total_subsystems; i++) {
+		finished_frame[i].allocations = frame_allocations[i].exchange(0);
+		finished_frame[i].bytes = frame_bytes[i].exchange(0);
+		if (budgets[i] >= 0 && finished_frame[i].allocations > budgets[i]) {
+			over_budget = true;
+		}
+	}
+	if (over_budget) {
+		over_budget_frames++;
+	}
+}
+
+int current_subsystem() {
+	return thread_subsystem;
+}
+
+allocation_counts last_frame(int subsystem) {
+	return finished_frame[subsystem];
+}
+
+void set_budget(int subsystem, long long allocations) {
+	budgets[subsystem] = allocations;
+}
+
+long long budget(int subsystem) {
+	return budgets[subsystem];
+}
+
+long long frames_over_budget() {
+	return over_budget_frames;
+}
+
+}
+
+#if WITH_ALLOCATION_TRACKING
+
+void* operator new(std::size_t size) {
+	count_allocation(size);
+	if (void* pointer{ std::malloc(size > 0 ? size : 1) }) {
+		return pointer;
+	}
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	count_allocation(size);
+	return std::malloc(size > 0 ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
+
+// Over-aligned types, such as ones with SIMD members, are allocated through these instead.
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	count_allocation(size);
+	if (void* pointer{ allocate_aligned(size, alignment) }) {
+		return pointer;
+	}
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	count_allocation(size);
+	return allocate_aligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return operator new(size, alignment, std::nothrow);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+	free_aligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+	free_aligned(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+	free_aligned(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {
+	free_aligned(pointer);
+}
+
+#endif
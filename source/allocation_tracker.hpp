@@ -0,0 +1,59 @@
+#pragma once
+
+// Replaces the global operator new/delete to count heap allocations per frame and subsystem.
+// Off by default. Enable with the WITH_ALLOCATION_TRACKING CMake option.
+#ifndef WITH_ALLOCATION_TRACKING
+#define WITH_ALLOCATION_TRACKING 0
+#endif
+
+namespace allocation_subsystem {
+constexpr int other{ 0 };
+constexpr int world{ 1 };
+constexpr int renderer{ 2 };
+constexpr int ui{ 3 };
+constexpr int total_subsystems{ 4 };
+
+const char* get_name(int subsystem);
+}
+
+struct allocation_counts {
+	long long allocations{ 0 };
+	long long bytes{ 0 };
+};
+
+// Attributes allocations made on this thread to a subsystem until the scope ends.
+class allocation_scope {
+public:
+
+	allocation_scope(int subsystem);
+	allocation_scope(const allocation_scope&) = delete;
+	allocation_scope(allocation_scope&&) = delete;
+	~allocation_scope();
+
+	allocation_scope& operator=(const allocation_scope&) = delete;
+	allocation_scope& operator=(allocation_scope&&) = delete;
+
+private:
+
+	int previous_subsystem{ allocation_subsystem::other };
+
+};
+
+namespace allocation_tracker {
+
+// Stores the counts of the frame that just ended, checks them against the budget and starts counting a new frame.
+void next_frame();
+
+// The subsystem allocations on this thread are attributed to right now.
+int current_subsystem();
+
+allocation_counts last_frame(int subsystem);
+
+// Number of allocations a subsystem may make per frame during steady-state play. Negative means unlimited.
+void set_budget(int subsystem, long long allocations);
+long long budget(int subsystem);
+
+// Frames where any subsystem went over its budget since tracking started.
+long long frames_over_budget();
+
+}
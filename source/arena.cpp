@@ -0,0 +1,59 @@
+#include "arena.hpp"
+
+counting_memory_resource::counting_memory_resource(std::pmr::memory_resource* upstream) : upstream{ upstream } {
+
+}
+
+long long counting_memory_resource::allocations() const {
+	return allocation_count;
+}
+
+long long counting_memory_resource::allocated_bytes() const {
+	return byte_count;
+}
+
+void counting_memory_resource::reset_counters() {
+	allocation_count = 0;
+	byte_count = 0;
+}
+
+void* counting_memory_resource::do_allocate(std::size_t bytes, std::size_t alignment) {
+	allocation_count++;
+	byte_count += static_cast<long long>(bytes);
+	return upstream->allocate(bytes, alignment);
+}
+
+void counting_memory_resource::do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) {
+	upstream->deallocate(pointer, bytes, alignment);
+}
+
+bool counting_memory_resource::do_is_equal(const std::pmr::memory_resource& that) const noexcept {
+	return this == &that;
+}
+
+dungeon_arena::dungeon_arena() : buffer(initial_size), heap{ std::pmr::new_delete_resource() },
+	arena{ buffer.data(), buffer.size(), &heap }, counter{ &arena } {
+
+}
+
+std::pmr::memory_resource* dungeon_arena::resource() {
+	return &counter;
+}
+
+void dungeon_arena::reset() {
+	arena.release();
+	counter.reset_counters();
+	heap.reset_counters();
+}
+
+long long dungeon_arena::allocations() const {
+	return counter.allocations();
+}
+
+long long dungeon_arena::allocated_bytes() const {
+	return counter.allocated_bytes();
+}
+
+long long dungeon_arena::heap_allocations() const {
+	return heap.allocations();
+}
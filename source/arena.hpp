@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+
+// Passes allocations on to another resource, and counts them.
+class counting_memory_resource : public std::pmr::memory_resource {
+public:
+
+	counting_memory_resource(std::pmr::memory_resource* upstream);
+
+	long long allocations() const;
+	long long allocated_bytes() const;
+
+	void reset_counters();
+
+private:
+
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+	void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& that) const noexcept override;
+
+	std::pmr::memory_resource* upstream{ nullptr };
+	long long allocation_count{ 0 };
+	long long byte_count{ 0 };
+
+};
+
+// Monotonic allocator for everything that lives as long as the current dungeon or lobby.
+// Memory is handed out from a preallocated buffer and is only given back in one go by reset(),
+// which must not be called while any container still holds memory from it.
+class dungeon_arena {
+public:
+
+	static constexpr std::size_t initial_size{ 1024 * 1024 };
+
+	dungeon_arena();
+	dungeon_arena(const dungeon_arena&) = delete;
+	dungeon_arena(dungeon_arena&&) = delete;
+
+	dungeon_arena& operator=(const dungeon_arena&) = delete;
+	dungeon_arena& operator=(dungeon_arena&&) = delete;
+
+	std::pmr::memory_resource* resource();
+	void reset();
+
+	// Allocations made through the arena since the last reset.
+	long long allocations() const;
+	long long allocated_bytes() const;
+
+	// Blocks the arena had to request from the heap because the initial buffer ran out.
+	long long heap_allocations() const;
+
+private:
+
+	std::vector<std::byte> buffer;
+	counting_memory_resource heap;
+	std::pmr::monotonic_buffer_resource arena;
+	counting_memory_resource counter;
+
+};
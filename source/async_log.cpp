@@ -0,0 +1,252 @@
+#include "async_log.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+constexpr int ring_size{ 4096 }; // Must be a power of two.
+constexpr int max_message_length{ 256 };
+
+struct log_entry {
+	// Equal to the slot index when free for the producer at that position, and one more when ready for the writer.
+	std::atomic<long long> sequence{ 0 };
+	int level{ 0 };
+	int category{ 0 };
+	const char* file{ nullptr };
+	const char* function{ nullptr };
+	int line{ 0 };
+	long long time_ms{ 0 };
+	char text[max_message_length]{};
+};
+
+struct category_rate {
+	std::atomic<int> limit{ -1 };
+	std::atomic<long long> window_start_ms{ 0 };
+	std::atomic<int> window_count{ 0 };
+	std::atomic<int> suppressed{ 0 };
+};
+
+log_entry ring[ring_size];
+std::atomic<long long> write_position{ 0 };
+long long read_position{ 0 };
+std::atomic<long long> dropped{ 0 };
+category_rate rates[log_category::total_categories];
+
+const auto epoch{ std::chrono::steady_clock::now() };
+std::atomic<bool> running{ false };
+std::thread writer;
+std::ofstream html_file;
+std::ofstream text_file;
+
+long long now_ms() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+bool is_rate_limited(int category, long long time_ms) {
+	auto& rate{ rates[category] };
+	const int limit{ rate.limit.load(std::memory_order_relaxed) };
+	if (limit < 0) {
+		return false;
+	}
+	long long window_start{ rate.window_start_ms.load(std::memory_order_relaxed) };
+	if (time_ms - window_start >= 1000 && rate.window_start_ms.compare_exchange_strong(window_start, time_ms)) {
+		rate.window_count = 0;
+	}
+	if (rate.window_count.fetch_add(1, std::memory_order_relaxed) < limit) {
+		return false;
+	}
+	rate.suppressed.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+const char* level_class(int level) {
+	switch (level) {
+	case log_level::warning: return "warning";
+	case log_level::critical: return "critical";
+	case log_level::info: return "info";
+	default: return "message";
+	}
+}
+
+const char* level_name(int level) {
+	switch (level) {
+	case log_level::warning: return "WARNING";
+	case log_level::critical: return "CRITICAL";
+	case log_level::info: return "INFO";
+	default: return "MESSAGE";
+	}
+}
+
+void write_html_escaped(const char* text) {
+	for (; *text; text++) {
+		switch (*text) {
+		case '<': html_file << "&lt;"; break;
+		case '>': html_file << "&gt;"; break;
+		case '&': html_file << "&amp;"; break;
+		case '\n': html_file << "<br>"; break;
+		default: html_file << *text; break;
+		}
+	}
+}
+
+void write_entry(int level, int category, const char* file, const char* function, int line, long long time_ms, const char* text) {
+	char time[32];
+	std::snprintf(time, sizeof(time), "%lld.%03lld", time_ms / 1000, time_ms % 1000);
+	if (html_file.is_open()) {
+		html_file << "<tr class=\"" << level_class(level) << "\"><td>" << time << "</td><td>[" << log_category::get_name(category) << "] ";
+		write_html_escaped(text);
+		html_file << "</td><td>";
+		write_html_escaped(file);
+		html_file << "</td><td>";
+		write_html_escaped(function);
+		html_file << "</td><td>" << line << "</td></tr>\n";
+	}
+	if (text_file.is_open()) {
+		text_file << "[" << time << "] [" << level_name(level) << "] [" << log_category::get_name(category) << "] " << text << " (" << file << ":" << line << ")\n";
+	}
+}
+
+// Only called from the writer thread, or after it has stopped.
+bool drain() {
+	bool wrote{ false };
+	while (true) {
+		auto& entry{ ring[read_position & (ring_size - 1)] };
+		if (entry.sequence.load(std::memory_order_acquire) != read_position + 1) {
+			break;
+		}
+		write_entry(entry.level, entry.category, entry.file, entry.function, entry.line, entry.time_ms, entry.text);
+		entry.sequence.store(read_position + ring_size, std::memory_order_release);
+		read_position++;
+		wrote = true;
+	}
+	for (int category{ 0 }; category < log_category::total_categories; category++) {
+		if (const int suppressed{ rates[category].suppressed.exchange(0) }; suppressed > 0) {
+			char text[64];
+			std::snprintf(text, sizeof(text), "%i messages suppressed by rate limit", suppressed);
+			write_entry(log_level::info, category, __FILE__, LOG_FUNCTION, __LINE__, now_ms(), text);
+			wrote = true;
+		}
+	}
+	if (wrote) {
+		html_file.flush();
+		text_file.flush();
+	}
+	return wrote;
+}
+
+void run_writer() {
+	while (running) {
+		if (!drain()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+		}
+	}
+	drain();
+}
+
+}
+
+namespace log_category {
+
+const char* get_name(int category) {
+	switch (category) {
+	case world: return "World";
+	case render: return "Render";
+	case ui: return "UI";
+	case audio: return "Audio";
+	case performance: return "Performance";
+	default: return "General";
+	}
+}
+
+}
+
+namespace async_log {
+
+void start(const std::string& html_path, const std::string& text_path) {
+	if (running) {
+		return;
+	}
+	for (long long i{ 0 }; i < ring_size; i++) {
+		ring[i].sequence = read_position + i;
+	}
+	write_position = read_position;
+	html_file.open(html_path);
+	if (html_file.is_open()) {
+		std::ifstream template_file{ "debug/template.html" };
+		if (template_file.is_open()) {
+			std::stringstream stream;
+			stream << template_file.rdbuf();
+			html_file << stream.str() << "\n";
+		} else {
+			html_file << "<!doctype html>\n<html>\n<body>\n<table>\n";
+		}
+	}
+	text_file.open(text_path);
+	running = true;
+	writer = std::thread{ run_writer };
+}
+
+void stop() {
+	if (!running) {
+		return;
+	}
+	running = false;
+	writer.join();
+	// The template leaves the table open, and browsers are fine with that.
+	html_file.close();
+	text_file.close();
+}
+
+void set_rate_limit(int category, int messages_per_second) {
+	rates[category].limit = messages_per_second;
+}
+
+long long dropped_messages() {
+	return dropped;
+}
+
+void write(int level, int category, const char* file, const char* function, int line, const char* format, ...) {
+	if (!running.load(std::memory_order_relaxed)) {
+		return;
+	}
+	const long long time_ms{ now_ms() };
+	if (is_rate_limited(category, time_ms)) {
+		return;
+	}
+	long long position{ write_position.load(std::memory_order_relaxed) };
+	log_entry* entry{ nullptr };
+	while (true) {
+		entry = &ring[position & (ring_size - 1)];
+		const long long sequence{ entry->sequence.load(std::memory_order_acquire) };
+		if (sequence == position) {
+			if (write_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (sequence < position) {
+			// The writer hasn't caught up. Never block the caller.
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		} else {
+			position = write_position.load(std::memory_order_relaxed);
+		}
+	}
+	entry->level = level;
+	entry->category = category;
+	entry->file = file;
+	entry->function = function;
+	entry->line = line;
+	entry->time_ms = time_ms;
+	va_list arguments;
+	va_start(arguments, format);
+	std::vsnprintf(entry->text, max_message_length, format, arguments);
+	va_end(arguments);
+	entry->sequence.store(position + 1, std::memory_order_release);
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+
+// Game-side logging that is cheap enough to leave on: callers format into a lock-free ring,
+// and a background thread appends the entries to an HTML log (following debug/template.html) and a plain text log.
+#define WITH_ASYNC_LOG 1
+
+namespace log_level {
+constexpr int message{ 0 };
+constexpr int warning{ 1 };
+constexpr int critical{ 2 };
+constexpr int info{ 3 };
+}
+
+namespace log_category {
+constexpr int general{ 0 };
+constexpr int world{ 1 };
+constexpr int render{ 2 };
+constexpr int ui{ 3 };
+constexpr int audio{ 4 };
+constexpr int performance{ 5 };
+constexpr int total_categories{ 6 };
+
+const char* get_name(int category);
+}
+
+namespace async_log {
+
+void start(const std::string& html_path, const std::string& text_path);
+
+// Writes everything that is still queued before returning.
+void stop();
+
+// Messages above the limit within a second are dropped, and summarised by the writer. Negative means unlimited.
+void set_rate_limit(int category, int messages_per_second);
+
+// Messages lost because the ring was full.
+long long dropped_messages();
+
+void write(int level, int category, const char* file, const char* function, int line, const char* format, ...);
+
+}
+
+#ifdef _MSC_VER
+#define LOG_FUNCTION __FUNCSIG__
+#else
+#define LOG_FUNCTION __PRETTY_FUNCTION__
+#endif
+
+#if WITH_ASYNC_LOG
+#define LOG_MESSAGE(CATEGORY, ...) async_log::write(log_level::message, CATEGORY, __FILE__, LOG_FUNCTION, __LINE__, __VA_ARGS__)
+#define LOG_WARNING(CATEGORY, ...) async_log::write(log_level::warning, CATEGORY, __FILE__, LOG_FUNCTION, __LINE__, __VA_ARGS__)
+#define LOG_CRITICAL(CATEGORY, ...) async_log::write(log_level::critical, CATEGORY, __FILE__, LOG_FUNCTION, __LINE__, __VA_ARGS__)
+#define LOG_INFO(CATEGORY, ...) async_log::write(log_level::info, CATEGORY, __FILE__, LOG_FUNCTION, __LINE__, __VA_ARGS__)
+#else
+#define LOG_MESSAGE(CATEGORY, ...)
+#define LOG_WARNING(CATEGORY, ...)
+#define LOG_CRITICAL(CATEGORY, ...)
+#define LOG_INFO(CATEGORY, ...)
+#endif
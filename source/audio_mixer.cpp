@@ -0,0 +1,152 @@
+#include "audio_mixer.hpp"
+#include "music_stream.hpp"
+#include "async_log.hpp"
+
+#include <vorbis/vorbisfile.h>
+
+#include <algorithm>
+
+bool sound_clip::load_ogg(const std::string& path) {
+	samples.clear();
+	OggVorbis_File file;
+	if (ov_fopen(path.c_str(), &file) != 0) {
+		LOG_WARNING(log_category::audio, "Failed to open %s", path.c_str());
+		return false;
+	}
+	const vorbis_info* info{ ov_info(&file, -1) };
+	if (!info || info->rate != audio_sample_rate || info->channels < 1 || info->channels > 2) {
+		LOG_WARNING(log_category::audio, "%s must be mono or stereo at %i Hz", path.c_str(), audio_sample_rate);
+		ov_clear(&file);
+		return false;
+	}
+	const int channels{ info->channels };
+	std::vector<short> decoded;
+	decoded.reserve(static_cast<size_t>(std::max(0LL, ov_pcm_total(&file, -1))) * channels);
+	char buffer[4096];
+	int bitstream{ 0 };
+	while (true) {
+		const long bytes{ ov_read(&file, buffer, sizeof(buffer), 0, 2, 1, &bitstream) };
+		if (bytes <= 0) {
+			break;
+		}
+		const short* pcm{ reinterpret_cast<const short*>(buffer) };
+		decoded.insert(decoded.end(), pcm, pcm + bytes / 2);
+	}
+	ov_clear(&file);
+	if (channels == 2) {
+		samples = std::move(decoded);
+	} else {
+		samples.reserve(decoded.size() * 2);
+		for (const short sample : decoded) {
+			samples.push_back(sample);
+			samples.push_back(sample);
+		}
+	}
+	return true;
+}
+
+const short* sound_clip::data() const {
+	return samples.data();
+}
+
+int sound_clip::frames() const {
+	return static_cast<int>(samples.size()) / audio_channels;
+}
+
+void audio_mixer::play(const sound_clip& clip, int priority, float volume) {
+	if (clip.frames() == 0) {
+		return;
+	}
+	std::lock_guard lock{ mutex };
+	voice* target{ nullptr };
+	for (auto& voice : voices) {
+		if (!voice.clip) {
+			target = &voice;
+			break;
+		}
+		if (voice.priority > priority) {
+			continue;
+		}
+		if (!target || voice.priority < target->priority || (voice.priority == target->priority && voice.started < target->started)) {
+			target = &voice;
+		}
+	}
+	if (!target) {
+		dropped++;
+		return;
+	}
+	if (target->clip) {
+		stolen++;
+	}
+	sounds_started++;
+	target->clip = &clip;
+	target->position = 0;
+	target->priority = priority;
+	target->volume = static_cast<int>(std::clamp(volume, 0.0f, 1.0f) * 256.0f);
+	target->started = sounds_started;
+}
+
+void audio_mixer::stop_all() {
+	std::lock_guard lock{ mutex };
+	for (auto& voice : voices) {
+		voice.clip = nullptr;
+	}
+}
+
+void audio_mixer::set_music(music_stream* new_music) {
+	std::lock_guard lock{ mutex };
+	music = new_music;
+}
+
+void audio_mixer::mix(short* output, int frames) {
+	std::lock_guard lock{ mutex };
+	for (int offset{ 0 }; offset < frames; offset += block_frames) {
+		mix_block(output + offset * audio_channels, std::min(block_frames, frames - offset));
+	}
+}
+
+int audio_mixer::active_voices() const {
+	std::lock_guard lock{ mutex };
+	int count{ 0 };
+	for (const auto& voice : voices) {
+		if (voice.clip) {
+			count++;
+		}
+	}
+	return count;
+}
+
+long long audio_mixer::stolen_voices() const {
+	std::lock_guard lock{ mutex };
+	return stolen;
+}
+
+long long audio_mixer::dropped_sounds() const {
+	std::lock_guard lock{ mutex };
+	return dropped;
+}
+
+void audio_mixer::mix_block(short* output, int frames) {
+	const int samples{ frames * audio_channels };
+	std::fill(accumulator.begin(), accumulator.begin() + samples, 0);
+	if (music) {
+		music->mix_into(accumulator.data(), frames);
+	}
+	for (auto& voice : voices) {
+		if (!voice.clip) {
+			continue;
+		}
+		const int voice_frames{ std::min(frames, voice.clip->frames() - voice.position) };
+		const short* source{ voice.clip->data() + voice.position * audio_channels };
+		for (int i{ 0 }; i < voice_frames * audio_channels; i++) {
+			accumulator[i] += source[i] * voice.volume / 256;
+		}
+		voice.position += voice_frames;
+		if (voice.position >= voice.clip->frames()) {
+			voice.clip = nullptr;
+		}
+	}
+	for (int i{ 0 }; i < samples; i++) {
+		output[i] = static_cast<short>(std::clamp(accumulator[i], -32768, 32767));
+	}
+}
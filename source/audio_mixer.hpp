@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class music_stream;
+
+constexpr int audio_sample_rate{ 44100 };
+constexpr int audio_channels{ 2 };
+
+// When every voice is busy, a sound can only take over a voice playing something of the same or lower priority.
+namespace sound_priority {
+constexpr int monster{ 0 };
+constexpr int player{ 1 };
+constexpr int ui{ 2 };
+}
+
+// A short sound decoded to interleaved 16-bit stereo up front, so playing it costs no decoding or allocation.
+class sound_clip {
+public:
+
+	bool load_ogg(const std::string& path);
+
+	const short* data() const;
+	int frames() const;
+
+private:
+
+	std::vector<short> samples;
+
+};
+
+// Mixes a fixed set of voices into interleaved 16-bit stereo. Sounds are started from the game thread,
+// and mixed on the audio thread.
+class audio_mixer {
+public:
+
+	static constexpr int max_voices{ 16 };
+
+	// Takes over the voice with the lowest priority that has played the longest when all are busy,
+	// and drops the sound if they all have a higher priority. The clip must outlive the mixer's use of it.
+	void play(const sound_clip& clip, int priority, float volume = 1.0f);
+	void stop_all();
+
+	// Mixed in under the voices. The stream must outlive the mixer's use of it.
+	void set_music(music_stream* music);
+
+	// Overwrites the output with the frames of all playing voices.
+	void mix(short* output, int frames);
+
+	int active_voices() const;
+	long long stolen_voices() const;
+	long long dropped_sounds() const;
+
+private:
+
+	static constexpr int block_frames{ 512 };
+
+	struct voice {
+		const sound_clip* clip{ nullptr };
+		int position{ 0 }; // in frames
+		int priority{ 0 };
+		int volume{ 0 }; // 256 is unchanged
+		long long started{ 0 };
+	};
+
+	void mix_block(short* output, int frames);
+
+	std::array<voice, max_voices> voices;
+	std::array<int, block_frames * audio_channels> accumulator{};
+	music_stream* music{ nullptr };
+	mutable std::mutex mutex;
+	long long sounds_started{ 0 };
+	long long stolen{ 0 };
+	long long dropped{ 0 };
+
+};
@@ -0,0 +1,244 @@
+#include "audio_output.hpp"
+#include "audio_mixer.hpp"
+#include "async_log.hpp"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include <mmsystem.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace audio_backend {
+
+const char* get_name(int backend) {
+	switch (backend) {
+	case device: return "Device";
+	case null: return "Null";
+	case wav_file: return "WAV file";
+	default: return "";
+	}
+}
+
+}
+
+namespace {
+
+template<typename T>
+void write_little_endian(std::ofstream& file, T value) {
+	for (size_t i{ 0 }; i < sizeof(T); i++) {
+		file.put(static_cast<char>((value >> (i * 8)) & 0xFF));
+	}
+}
+
+// The sizes are written again once the length is known.
+void write_wav_header(std::ofstream& file, uint32_t data_bytes) {
+	const uint16_t block_align{ audio_channels * sizeof(short) };
+	file.write("RIFF", 4);
+	write_little_endian<uint32_t>(file, 36 + data_bytes);
+	file.write("WAVEfmt ", 8);
+	write_little_endian<uint32_t>(file, 16);
+	write_little_endian<uint16_t>(file, 1); // PCM
+	write_little_endian<uint16_t>(file, audio_channels);
+	write_little_endian<uint32_t>(file, audio_sample_rate);
+	write_little_endian<uint32_t>(file, audio_sample_rate * block_align);
+	write_little_endian<uint16_t>(file, block_align);
+	write_little_endian<uint16_t>(file, 16);
+	file.write("data", 4);
+	write_little_endian<uint32_t>(file, data_bytes);
+}
+
+}
+
+audio_output::audio_output(audio_mixer& mixer) : mixer{ mixer } {
+
+}
+
+audio_output::~audio_output() {
+	stop();
+}
+
+bool audio_output::start(int backend, const std::string& wav_path) {
+	if (running) {
+		return true;
+	}
+	current_backend = backend;
+	frames_mixed = 0;
+	if (backend == audio_backend::device) {
+		return start_device();
+	}
+	if (backend == audio_backend::wav_file) {
+		wav.open(wav_path, std::ios::binary);
+		if (!wav.is_open()) {
+			LOG_WARNING(log_category::audio, "Failed to open %s", wav_path.c_str());
+			return false;
+		}
+		wav_data_bytes = 0;
+		write_wav_header(wav, 0);
+	}
+	LOG_INFO(log_category::audio, "Mixing audio without a device (%s backend)", audio_backend::get_name(backend));
+	running = true;
+	thread = std::thread{ [this] {
+		run_without_device();
+	} };
+	return true;
+}
+
+void audio_output::stop() {
+	if (!running) {
+		return;
+	}
+	if (current_backend == audio_backend::device) {
+		stop_device();
+		return;
+	}
+	running = false;
+	thread.join();
+	if (wav.is_open()) {
+		wav.seekp(0);
+		write_wav_header(wav, static_cast<uint32_t>(wav_data_bytes));
+		wav.close();
+	}
+}
+
+bool audio_output::is_running() const {
+	return running;
+}
+
+int audio_output::backend() const {
+	return current_backend;
+}
+
+long long audio_output::mixed_frames() const {
+	return frames_mixed;
+}
+
+bool audio_output::render_to_wav(const std::string& path, long long frames, const std::function<void(long long)>& before_buffer) {
+	if (running) {
+		LOG_WARNING(log_category::audio, "Can't render to %s while the output is running", path.c_str());
+		return false;
+	}
+	std::ofstream file{ path, std::ios::binary };
+	if (!file.is_open()) {
+		LOG_WARNING(log_category::audio, "Failed to open %s", path.c_str());
+		return false;
+	}
+	// The length is known up front, so the header is right from the start.
+	write_wav_header(file, static_cast<uint32_t>(frames * audio_channels * sizeof(short)));
+	std::vector<short> samples(buffer_frames * audio_channels);
+	frames_mixed = 0;
+	for (long long frame{ 0 }; frame < frames; frame += buffer_frames) {
+		const int count{ static_cast<int>(std::min<long long>(buffer_frames, frames - frame)) };
+		before_buffer(frame);
+		mixer.mix(samples.data(), count);
+		file.write(reinterpret_cast<const char*>(samples.data()), count * audio_channels * sizeof(short));
+		frames_mixed += count;
+	}
+	return file.good();
+}
+
+void audio_output::run_without_device() {
+	// Paced like a device would be, so the game behaves the same as with sound hardware.
+	std::vector<short> samples(buffer_frames * audio_channels);
+	const std::chrono::nanoseconds buffer_duration{ 1'000'000'000LL * buffer_frames / audio_sample_rate };
+	auto next_buffer{ std::chrono::steady_clock::now() };
+	while (running) {
+		mixer.mix(samples.data(), buffer_frames);
+		frames_mixed += buffer_frames;
+		if (wav.is_open()) {
+			wav.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(short));
+			wav_data_bytes += samples.size() * sizeof(short);
+		}
+		next_buffer += buffer_duration;
+		std::this_thread::sleep_until(next_buffer);
+	}
+}
+
+#ifdef _WIN32
+
+bool audio_output::start_device() {
+	WAVEFORMATEX format{};
+	format.wFormatTag = WAVE_FORMAT_PCM;
+	format.nChannels = audio_channels;
+	format.nSamplesPerSec = audio_sample_rate;
+	format.wBitsPerSample = 16;
+	format.nBlockAlign = static_cast<WORD>(format.nChannels * format.wBitsPerSample / 8);
+	format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+	buffer_done_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	HWAVEOUT wave_out{ nullptr };
+	if (waveOutOpen(&wave_out, WAVE_MAPPER, &format, reinterpret_cast<DWORD_PTR>(buffer_done_event), 0, CALLBACK_EVENT) != MMSYSERR_NOERROR) {
+		LOG_WARNING(log_category::audio, "Failed to open the audio output device");
+		CloseHandle(buffer_done_event);
+		buffer_done_event = nullptr;
+		return false;
+	}
+	device = wave_out;
+	running = true;
+	thread = std::thread{ [this] {
+		run_device();
+	} };
+	return true;
+}
+
+void audio_output::stop_device() {
+	running = false;
+	SetEvent(buffer_done_event);
+	thread.join();
+	waveOutClose(static_cast<HWAVEOUT>(device));
+	CloseHandle(buffer_done_event);
+	device = nullptr;
+	buffer_done_event = nullptr;
+}
+
+void audio_output::run_device() {
+	const auto wave_out{ static_cast<HWAVEOUT>(device) };
+	std::vector<short> samples(buffer_count * buffer_frames * audio_channels);
+	WAVEHDR headers[buffer_count]{};
+	for (int i{ 0 }; i < buffer_count; i++) {
+		headers[i].lpData = reinterpret_cast<LPSTR>(samples.data() + i * buffer_frames * audio_channels);
+		headers[i].dwBufferLength = buffer_frames * audio_channels * sizeof(short);
+		waveOutPrepareHeader(wave_out, &headers[i], sizeof(WAVEHDR));
+		headers[i].dwFlags |= WHDR_DONE;
+	}
+	while (running) {
+		for (auto& header : headers) {
+			if (header.dwFlags & WHDR_DONE) {
+				mixer.mix(reinterpret_cast<short*>(header.lpData), buffer_frames);
+				frames_mixed += buffer_frames;
+				header.dwFlags &= ~WHDR_DONE;
+				waveOutWrite(wave_out, &header, sizeof(WAVEHDR));
+			}
+		}
+		WaitForSingleObject(buffer_done_event, INFINITE);
+	}
+	waveOutReset(wave_out);
+	for (auto& header : headers) {
+		waveOutUnprepareHeader(wave_out, &header, sizeof(WAVEHDR));
+	}
+}
+
+#else
+
+bool audio_output::start_device() {
+	LOG_WARNING(log_category::audio, "No audio output device on this platform");
+	return false;
+}
+
+void audio_output::stop_device() {
+
+}
+
+void audio_output::run_device() {
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+
+class audio_mixer;
+
+namespace audio_backend {
+constexpr int device{ 0 }; // the default output device
+constexpr int null{ 1 }; // mixes at the same pace as a device, but discards the result
+constexpr int wav_file{ 2 }; // like null, but writes the result to a WAV file
+
+const char* get_name(int backend);
+}
+
+// Plays what the mixer produces. A few short buffers are kept queued, and refilled by a background thread as they are played.
+// The null and WAV file backends let audio be verified and profiled without sound hardware.
+class audio_output {
+public:
+
+	static constexpr int buffer_count{ 4 };
+	static constexpr int buffer_frames{ 512 }; // about 12 ms each
+
+	audio_output(audio_mixer& mixer);
+	audio_output(const audio_output&) = delete;
+	audio_output(audio_output&&) = delete;
+	~audio_output();
+
+	audio_output& operator=(const audio_output&) = delete;
+	audio_output& operator=(audio_output&&) = delete;
+
+	bool start(int backend = audio_backend::device, const std::string& wav_path = {});
+	void stop();
+	bool is_running() const;
+	int backend() const;
+	long long mixed_frames() const;
+
+	// Mixes the given number of frames straight into a WAV file as fast as the mixer can, on the calling thread.
+	// The callback gets the first frame of each buffer before it is mixed, so sounds can be started at set times.
+	bool render_to_wav(const std::string& path, long long frames, const std::function<void(long long)>& before_buffer);
+
+private:
+
+	bool start_device();
+	void stop_device();
+	void run_device();
+	void run_without_device();
+
+	audio_mixer& mixer;
+	int current_backend{ audio_backend::device };
+	std::thread thread;
+	std::atomic<bool> running{ false };
+	std::atomic<long long> frames_mixed{ 0 };
+	void* device{ nullptr };
+	void* buffer_done_event{ nullptr };
+	std::ofstream wav;
+	long long wav_data_bytes{ 0 };
+
+};
@@ -0,0 +1,60 @@
+#include "audio_render.hpp"
+#include "audio_mixer.hpp"
+#include "audio_output.hpp"
+#include "music_stream.hpp"
+#include "async_log.hpp"
+#include "assets.hpp"
+
+namespace {
+
+struct scripted_sound {
+	const sound_clip* clip{ nullptr };
+	int priority{ sound_priority::monster };
+	long long interval_frames{ 0 };
+	long long first_frame{ 0 };
+};
+
+}
+
+bool render_audio_script(const std::string& path, int seconds) {
+	sound_clip stab_sound;
+	sound_clip magic_sound;
+	sound_clip magic2_sound;
+	stab_sound.load_ogg(no::asset_path("sounds/stab.ogg"));
+	magic_sound.load_ogg(no::asset_path("sounds/magic.ogg"));
+	magic2_sound.load_ogg(no::asset_path("sounds/magic2.ogg"));
+	music_stream music;
+	audio_mixer mixer;
+	if (music.open(no::asset_path("sounds/bg.ogg"))) {
+		mixer.set_music(&music);
+	}
+	// A fight: the player attacks and casts, and after two seconds monsters cast often enough to keep most voices busy.
+	const scripted_sound script[]{
+		{ &stab_sound, sound_priority::player, audio_sample_rate / 2, 0 },
+		{ &magic_sound, sound_priority::player, audio_sample_rate * 3 / 2, audio_sample_rate / 4 },
+		{ &magic2_sound, sound_priority::monster, audio_sample_rate / 8, audio_sample_rate * 2 },
+		{ &magic_sound, sound_priority::monster, audio_sample_rate / 10, audio_sample_rate * 2 }
+	};
+	audio_output output{ mixer };
+	const long long frames{ static_cast<long long>(seconds) * audio_sample_rate };
+	const bool written{ output.render_to_wav(path, frames, [&](long long frame) {
+		// Sounds start on buffer boundaries, about 12 ms apart.
+		const long long end_frame{ frame + audio_output::buffer_frames };
+		for (const auto& sound : script) {
+			if (end_frame <= sound.first_frame) {
+				continue;
+			}
+			const long long previous_start{ (frame - sound.first_frame + sound.interval_frames - 1) / sound.interval_frames };
+			const long long next_start{ (end_frame - sound.first_frame + sound.interval_frames - 1) / sound.interval_frames };
+			for (long long i{ std::max(0LL, previous_start) }; i < next_start; i++) {
+				mixer.play(*sound.clip, sound.priority);
+			}
+		}
+		music.wait_until_buffered(audio_output::buffer_frames);
+	}) };
+	mixer.set_music(nullptr);
+	if (written) {
+		LOG_INFO(log_category::audio, "Rendered %i seconds of audio to %s", seconds, path.c_str());
+	}
+	return written;
+}
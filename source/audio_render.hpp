@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+
+// Mixes the game's music and a fixed sequence of sound effects into a WAV file, without a window or real-time pacing.
+// The sequence is the same on every run, so the file can be compared between builds. Returns false if nothing was written.
+bool render_audio_script(const std::string& path, int seconds);
@@ -0,0 +1,234 @@
+#include "benchmark.hpp"
+#include "game.hpp"
+#include "generator.hpp"
+#include "item.hpp"
+#include "async_log.hpp"
+#include "audio_mixer.hpp"
+#include "audio_output.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <memory>
+
+namespace {
+
+constexpr long long time_budget_ns{ 200'000'000 };
+constexpr long long max_iterations{ 100'000 };
+constexpr int monster_counts[]{ 10, 100, 1000, 10000 };
+constexpr int mixer_voice_counts[]{ 1, 4, audio_mixer::max_voices };
+
+// Common monsters only. Bosses change the world state when they die.
+constexpr int synthetic_monster_types[]{
+	monster_type::skeleton,
+	monster_type::knight,
+	monster_type::dark_wizard,
+	monster_type::big_fire_slime,
+	monster_type::small_water_slime,
+	monster_type::fire_imp
+};
+
+long long now_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The operation returns how many operations it did, so cheap calls can be timed in batches.
+template<typename Setup, typename Operation>
+world_benchmark::result measure(const char* name, int n, Setup&& setup, Operation&& operation) {
+	setup();
+	operation(); // warm up
+	long long elapsed_ns{ 0 };
+	long long iterations{ 0 };
+	world_benchmark::result result;
+	result.name = name;
+	result.n = n;
+	while (elapsed_ns < time_budget_ns && iterations < max_iterations) {
+		setup();
+		const long long start_ns{ now_ns() };
+		result.operations += operation();
+		elapsed_ns += now_ns() - start_ns;
+		iterations++;
+	}
+	result.ns_per_operation = static_cast<double>(elapsed_ns) / static_cast<double>(std::max(1LL, result.operations));
+	return result;
+}
+
+// A walled room of floor tiles, with the player in the middle and monsters spread over the floor.
+game_world_room& make_synthetic_room(game_world& world, int monsters) {
+	world.clear_rooms();
+	world.random = no::random_number_generator{ 45 };
+	const int side{ std::max(16, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(monsters) * 2.0))) + 2) };
+	auto& room{ world.rooms.emplace_back(world) };
+	room.resize(side, side);
+	for (int y{ 0 }; y < side; y++) {
+		for (int x{ 0 }; x < side; x++) {
+			const bool is_border{ x == 0 || y == 0 || x == side - 1 || y == side - 1 };
+			room.set_tile(x, y, is_border ? tile_type::wall : tile_type::floor);
+		}
+	}
+	room.build_spawn_tiles();
+	room.initial_monsters_spawned = true;
+	room.monsters.reserve(monsters);
+	for (int i{ 0 }; i < monsters; i++) {
+		const int type{ synthetic_monster_types[i % std::size(synthetic_monster_types)] };
+		auto& monster{ world.spawn_monster(room, type) };
+		monster.transform.position = {
+			static_cast<float>(world.random.next<int>(1, side - 2) * tile_size),
+			static_cast<float>(world.random.next<int>(1, side - 2) * tile_size)
+		};
+	}
+	world.index_room_objects(room);
+	world.player.room = &room;
+	world.player.transform.position = static_cast<float>(side * tile_size) / 2.0f;
+	return room;
+}
+
+no::vector2f random_position_in(game_world& world, const game_world_room& room) {
+	return {
+		static_cast<float>(room.left() * tile_size + world.random.next<int>(0, room.width() * tile_size - 1)),
+		static_cast<float>(room.top() * tile_size + world.random.next<int>(0, room.height() * tile_size - 1))
+	};
+}
+
+void fill_attacks(game_world& world, game_world_room& room) {
+	while (room.attacks.size() > 0) {
+		room.attacks.remove(0);
+	}
+	while (room.attacks.size() < game_world_room::active_attack_pool::capacity) {
+		auto attack{ room.attacks.add() };
+		attack->by_player = world.random.chance(0.5f);
+		attack->type = attack->by_player ? item_type::fire_staff : monster_type::dark_wizard;
+		attack->position = random_position_in(world, room);
+		attack->size = 16.0f;
+		attack->speed = { world.random.next<float>(-2.0f, 2.0f), world.random.next<float>(-2.0f, 2.0f) };
+		attack->max_life_ticks = ticks_per_second;
+		attack->health = 1000;
+	}
+}
+
+}
+
+world_benchmark::world_benchmark(game_state& game) : game{ game } {
+
+}
+
+void world_benchmark::run() {
+	finished_results.clear();
+	auto world{ std::make_unique<game_world>() };
+	world->game = &game;
+	game_world_generator generator;
+	// The world's events are only handled for the game's own world, so they are dropped here.
+	const auto reset_player_and_events{ [&] {
+		world->player.stats.health = 1000000.0f;
+		world->events.clear();
+	} };
+
+	finished_results.push_back(measure("generate_dungeon", 1, [&] {
+		world->clear_rooms();
+	}, [&] {
+		generator.generate_dungeon(*world, 'f');
+		return 1LL;
+	}));
+	finished_results.push_back(measure("find_room", static_cast<int>(world->rooms.size()), [] {}, [&] {
+		for (int i{ 0 }; i < 1000; i++) {
+			const auto& room{ world->rooms[i % world->rooms.size()] };
+			world->find_room(random_position_in(*world, room));
+		}
+		return 1000LL;
+	}));
+
+	for (const int n : monster_counts) {
+		auto& room{ make_synthetic_room(*world, n) };
+		finished_results.push_back(measure("test_tile_mask", n, [] {}, [&] {
+			for (int i{ 0 }; i < 1000; i++) {
+				world->test_tile_mask(room, random_position_in(*world, room));
+			}
+			return 1000LL;
+		}));
+		std::vector<uint32_t> overlap_mask;
+		finished_results.push_back(measure("aabb_batch::overlaps", n, [] {}, [&] {
+			for (int i{ 0 }; i < 100; i++) {
+				room.collision_boxes.overlaps(random_position_in(*world, room), 16.0f, overlap_mask);
+			}
+			return 100LL;
+		}));
+		finished_results.push_back(measure("aabb_batch::overlaps_scalar", n, [] {}, [&] {
+			for (int i{ 0 }; i < 100; i++) {
+				room.collision_boxes.overlaps_scalar(random_position_in(*world, room), 16.0f, overlap_mask);
+			}
+			return 100LL;
+		}));
+		finished_results.push_back(measure("get_allowed_movement_delta", n, [] {}, [&] {
+			for (int i{ 0 }; i < 100; i++) {
+				world->get_allowed_movement_delta(&room, i % 2 == 0, i % 2 == 1, i % 4 < 2, i % 4 >= 2, 2.0f, random_position_in(*world, room), 16.0f);
+			}
+			return 100LL;
+		}));
+		const std::vector<monster_object> initial_monsters{ room.monsters.begin(), room.monsters.end() };
+		const auto restore_monsters{ [&] {
+			room.monsters.assign(initial_monsters.begin(), initial_monsters.end());
+			world->index_room_objects(room);
+		} };
+		finished_results.push_back(measure("process_attacks", n, [&] {
+			restore_monsters();
+			room.pending_events.clear();
+			fill_attacks(*world, room);
+			reset_player_and_events();
+		}, [&] {
+			room.process_attacks();
+			return 1LL;
+		}));
+		finished_results.push_back(measure("game_world::update", n, [&] {
+			reset_player_and_events();
+		}, [&] {
+			world->update();
+			return 1LL;
+		}));
+	}
+
+	// One operation is one output buffer, so the cost per voice is the time divided by n.
+	audio_mixer mixer;
+	std::vector<short> mixed(audio_output::buffer_frames * audio_channels);
+	for (const int voices : mixer_voice_counts) {
+		finished_results.push_back(measure("audio_mixer::mix", voices, [&] {
+			mixer.stop_all();
+			for (int i{ 0 }; i < voices; i++) {
+				mixer.play(game.stab_sound, sound_priority::player);
+			}
+		}, [&] {
+			mixer.mix(mixed.data(), audio_output::buffer_frames);
+			return 1LL;
+		}));
+	}
+
+	for (auto& result : finished_results) {
+		for (const auto& previous : finished_results) {
+			if (&previous == &result) {
+				break;
+			}
+			if (previous.name == result.name && previous.n > 0 && result.n > previous.n && previous.ns_per_operation > 0.0) {
+				const double n_ratio{ static_cast<double>(result.n) / static_cast<double>(previous.n) };
+				result.scaling = std::log(result.ns_per_operation / previous.ns_per_operation) / std::log(n_ratio);
+			}
+		}
+		LOG_INFO(log_category::performance, "%s (n = %i): %.1f ns/op, scaling %.2f", result.name.c_str(), result.n, result.ns_per_operation, result.scaling);
+	}
+
+	world.reset();
+}
+
+const std::vector<world_benchmark::result>& world_benchmark::results() const {
+	return finished_results;
+}
+
+bool world_benchmark::write_csv(const std::string& path) const {
+	std::ofstream file{ path };
+	if (!file.is_open()) {
+		return false;
+	}
+	file << "name,n,operations,ns_per_operation,scaling\n";
+	for (const auto& result : finished_results) {
+		file << result.name << ',' << result.n << ',' << result.operations << ',' << result.ns_per_operation << ',' << result.scaling << '\n';
+	}
+	return true;
+}
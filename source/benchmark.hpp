@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class game_state;
+
+// Times the world simulation hot paths on synthetic rooms with an increasing number of monsters, and the sound mixer with an increasing number of voices.
+// Runs inside the game since the world needs loaded assets, but uses its own worlds so the current session is left alone.
+class world_benchmark {
+public:
+
+	struct result {
+		std::string name;
+		int n{ 0 };
+		long long operations{ 0 };
+		double ns_per_operation{ 0.0 };
+		// Growth of the cost relative to the previous n of the same benchmark. 1 is linear, 2 is quadratic.
+		double scaling{ 0.0 };
+	};
+
+	world_benchmark(game_state& game);
+
+	void run();
+	const std::vector<result>& results() const;
+	bool write_csv(const std::string& path) const;
+
+private:
+
+	game_state& game;
+	std::vector<result> finished_results;
+
+};
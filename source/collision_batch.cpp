@@ -0,0 +1,164 @@
+#include "collision_batch.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#if WITH_SIMD_COLLISION
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Inverted so that no box can overlap it.
+constexpr float disabled_min{ 1.0e30f };
+constexpr float disabled_max{ -1.0e30f };
+
+#if WITH_SIMD_COLLISION
+int overlap_mask_of_four(const float* min_x, const float* min_y, const float* max_x, const float* max_y, __m128 test_min_x, __m128 test_min_y, __m128 test_max_x, __m128 test_max_y) {
+	const __m128 overlap_x{ _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(min_x), test_max_x), _mm_cmpge_ps(_mm_loadu_ps(max_x), test_min_x)) };
+	const __m128 overlap_y{ _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(min_y), test_max_y), _mm_cmpge_ps(_mm_loadu_ps(max_y), test_min_y)) };
+	return _mm_movemask_ps(_mm_and_ps(overlap_x, overlap_y));
+}
+#endif
+
+int count_bits(uint32_t bits) {
+	int count{ 0 };
+	for (; bits != 0; bits &= bits - 1) {
+		count++;
+	}
+	return count;
+}
+
+}
+
+void aabb_batch::clear() {
+	min_x.clear();
+	min_y.clear();
+	max_x.clear();
+	max_y.clear();
+	count = 0;
+}
+
+int aabb_batch::add(no::vector2f position, no::vector2f size) {
+	const int index{ count };
+	count++;
+	pad();
+	set(index, position, size);
+	return index;
+}
+
+void aabb_batch::set(int index, no::vector2f position, no::vector2f size) {
+	min_x[index] = position.x;
+	min_y[index] = position.y;
+	max_x[index] = position.x + size.x;
+	max_y[index] = position.y + size.y;
+}
+
+void aabb_batch::disable(int index) {
+	min_x[index] = disabled_min;
+	min_y[index] = disabled_min;
+	max_x[index] = disabled_max;
+	max_y[index] = disabled_max;
+}
+
+int aabb_batch::size() const {
+	return count;
+}
+
+int aabb_batch::overlaps(no::vector2f position, no::vector2f size, std::vector<uint32_t>& mask) const {
+#if WITH_SIMD_COLLISION
+	mask.assign((count + 31) / 32, 0);
+	const __m128 test_min_x{ _mm_set1_ps(position.x) };
+	const __m128 test_min_y{ _mm_set1_ps(position.y) };
+	const __m128 test_max_x{ _mm_set1_ps(position.x + size.x) };
+	const __m128 test_max_y{ _mm_set1_ps(position.y + size.y) };
+	int overlapping{ 0 };
+	for (int i{ 0 }; i < count; i += 4) {
+		const int hits{ overlap_mask_of_four(&min_x[i], &min_y[i], &max_x[i], &max_y[i], test_min_x, test_min_y, test_max_x, test_max_y) };
+		if (hits != 0) {
+			mask[i / 32] |= static_cast<uint32_t>(hits) << (i % 32);
+			overlapping += count_bits(static_cast<uint32_t>(hits));
+		}
+	}
+	return overlapping;
+#else
+	return overlaps_scalar(position, size, mask);
+#endif
+}
+
+int aabb_batch::overlaps_scalar(no::vector2f position, no::vector2f size, std::vector<uint32_t>& mask) const {
+	mask.assign((count + 31) / 32, 0);
+	const no::vector2f end{ position + size };
+	int overlapping{ 0 };
+	for (int i{ 0 }; i < count; i++) {
+		if (min_x[i] <= end.x && max_x[i] >= position.x && min_y[i] <= end.y && max_y[i] >= position.y) {
+			mask[i / 32] |= 1u << (i % 32);
+			overlapping++;
+		}
+	}
+	return overlapping;
+}
+
+int aabb_batch::first_overlap(no::vector2f position, no::vector2f size) const {
+#if WITH_SIMD_COLLISION
+	const __m128 test_min_x{ _mm_set1_ps(position.x) };
+	const __m128 test_min_y{ _mm_set1_ps(position.y) };
+	const __m128 test_max_x{ _mm_set1_ps(position.x + size.x) };
+	const __m128 test_max_y{ _mm_set1_ps(position.y + size.y) };
+	for (int i{ 0 }; i < count; i += 4) {
+		if (const int hits{ overlap_mask_of_four(&min_x[i], &min_y[i], &max_x[i], &max_y[i], test_min_x, test_min_y, test_max_x, test_max_y) }) {
+			for (int bit{ 0 }; bit < 4; bit++) {
+				if (hits & (1 << bit)) {
+					return i + bit;
+				}
+			}
+		}
+	}
+	return -1;
+#else
+	const no::vector2f end{ position + size };
+	for (int i{ 0 }; i < count; i++) {
+		if (min_x[i] <= end.x && max_x[i] >= position.x && min_y[i] <= end.y && max_y[i] >= position.y) {
+			return i;
+		}
+	}
+	return -1;
+#endif
+}
+
+void aabb_batch::pad() {
+	const int padded{ (count + 3) / 4 * 4 };
+	if (static_cast<int>(min_x.size()) >= padded) {
+		return;
+	}
+	min_x.resize(padded, disabled_min);
+	min_y.resize(padded, disabled_min);
+	max_x.resize(padded, disabled_max);
+	max_y.resize(padded, disabled_max);
+}
+
+float swept_overlap_time(no::vector2f position, no::vector2f size, no::vector2f delta, no::vector2f target_position, no::vector2f target_size) {
+	// Grow the target by the moving box, and cast a ray from the moving box's corner through it.
+	const float target_min[2]{ target_position.x - size.x, target_position.y - size.y };
+	const float target_max[2]{ target_position.x + target_size.x, target_position.y + target_size.y };
+	const float start[2]{ position.x, position.y };
+	const float direction[2]{ delta.x, delta.y };
+	float entry{ -std::numeric_limits<float>::infinity() };
+	float exit{ std::numeric_limits<float>::infinity() };
+	for (int axis{ 0 }; axis < 2; axis++) {
+		if (direction[axis] == 0.0f) {
+			if (start[axis] < target_min[axis] || start[axis] > target_max[axis]) {
+				return -1.0f;
+			}
+			continue;
+		}
+		const float near_time{ (target_min[axis] - start[axis]) / direction[axis] };
+		const float far_time{ (target_max[axis] - start[axis]) / direction[axis] };
+		entry = std::max(entry, std::min(near_time, far_time));
+		exit = std::min(exit, std::max(near_time, far_time));
+	}
+	if (entry > exit || exit < 0.0f || entry > 1.0f) {
+		return -1.0f;
+	}
+	return std::max(0.0f, entry);
+}
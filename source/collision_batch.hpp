@@ -0,0 +1,47 @@
+#pragma once
+
+#include "math.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WITH_SIMD_COLLISION 1
+#else
+#define WITH_SIMD_COLLISION 0
+#endif
+
+// Axis-aligned boxes packed as separate coordinate arrays, so one box or point can be tested against four at a time.
+// Edges that touch count as overlapping, like no::transform2::collides_with.
+class aabb_batch {
+public:
+
+	void clear();
+	int add(no::vector2f position, no::vector2f size);
+	void set(int index, no::vector2f position, no::vector2f size);
+	// Disabled boxes never overlap anything, but keep their index.
+	void disable(int index);
+	int size() const;
+
+	// Bit i of word i / 32 is set for every box i that overlaps. Returns the number of overlapping boxes.
+	int overlaps(no::vector2f position, no::vector2f size, std::vector<uint32_t>& mask) const;
+	int overlaps_scalar(no::vector2f position, no::vector2f size, std::vector<uint32_t>& mask) const;
+
+	// Index of the first overlapping box, or -1.
+	int first_overlap(no::vector2f position, no::vector2f size) const;
+
+private:
+
+	void pad();
+
+	// Padded to a multiple of four with disabled boxes.
+	std::vector<float> min_x;
+	std::vector<float> min_y;
+	std::vector<float> max_x;
+	std::vector<float> max_y;
+	int count{ 0 };
+
+};
+
+// Fraction of the move in [0, 1] at which a box moving by delta first touches the target box, or -1 if it never does.
+float swept_overlap_time(no::vector2f position, no::vector2f size, no::vector2f delta, no::vector2f target_position, no::vector2f target_size);
@@ -0,0 +1,45 @@
+#include "command_line.hpp"
+
+#include <cstdlib>
+
+namespace {
+
+// The engine owns the entry point, so read the arguments the C runtime keeps around.
+std::optional<std::string> find_option(const std::string& name) {
+#ifdef _WIN32
+	const std::string prefix{ "--" + name };
+	for (int i{ 1 }; i < __argc; i++) {
+		const std::string argument{ __argv[i] };
+		if (argument == prefix) {
+			return "";
+		}
+		if (argument.size() > prefix.size() && argument.compare(0, prefix.size(), prefix) == 0 && argument[prefix.size()] == '=') {
+			return argument.substr(prefix.size() + 1);
+		}
+	}
+#endif
+	return std::nullopt;
+}
+
+}
+
+bool has_command_line_option(const std::string& name) {
+	return find_option(name).has_value();
+}
+
+std::optional<int> get_command_line_int(const std::string& name) {
+	const auto value{ find_option(name) };
+	if (!value || value->empty()) {
+		return std::nullopt;
+	}
+	char* end{ nullptr };
+	const long number{ std::strtol(value->c_str(), &end, 10) };
+	if (*end != '\0') {
+		return std::nullopt;
+	}
+	return static_cast<int>(number);
+}
+
+std::optional<std::string> get_command_line_string(const std::string& name) {
+	return find_option(name);
+}
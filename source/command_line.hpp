@@ -0,0 +1,9 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+// Options are passed as --name or --name=value.
+bool has_command_line_option(const std::string& name);
+std::optional<int> get_command_line_int(const std::string& name);
+std::optional<std::string> get_command_line_string(const std::string& name);
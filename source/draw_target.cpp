@@ -0,0 +1,235 @@
+#include "draw_target.hpp"
+#include "software_renderer.hpp"
+#include "surface.hpp"
+#include "assets.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+software_renderer* software_target{ nullptr };
+bool headless{ false };
+int next_headless_texture{ 1 };
+no::transform2 current_model;
+
+// Named textures are loaded again from their files. Created textures have no file, so a copy of their pixels is kept.
+// While headless, all textures are kept as copies.
+std::unordered_map<int, std::string> texture_names;
+std::unordered_map<int, software_renderer::texture_pixels> texture_copies;
+
+software_renderer::texture_pixels copy_pixels(const no::surface& surface) {
+	software_renderer::texture_pixels texture;
+	texture.width = surface.width();
+	texture.height = surface.height();
+	texture.pixels.reserve(surface.count());
+	for (int y{ 0 }; y < surface.height(); y++) {
+		for (int x{ 0 }; x < surface.width(); x++) {
+			texture.pixels.push_back(surface.at(x, y));
+		}
+	}
+	return texture;
+}
+
+void upload_to_software_target(int texture) {
+	if (software_target->has_texture(texture)) {
+		return;
+	}
+	if (const auto copy{ texture_copies.find(texture) }; copy != texture_copies.end()) {
+		software_target->set_texture(texture, copy->second);
+	} else if (const auto name{ texture_names.find(texture) }; name != texture_names.end()) {
+		software_target->set_texture(texture, copy_pixels(no::surface{ no::asset_path("textures/" + name->second + ".png") }));
+	}
+}
+
+}
+
+namespace draw_target {
+
+void set_software(software_renderer* target) {
+	software_target = target;
+}
+
+void set_headless(bool new_headless) {
+	headless = new_headless;
+}
+
+int require_texture(const std::string& name) {
+	if (headless) {
+		for (const auto& [texture, texture_name] : texture_names) {
+			if (texture_name == name) {
+				return texture;
+			}
+		}
+		const int texture{ next_headless_texture++ };
+		texture_names[texture] = name;
+		texture_copies[texture] = copy_pixels(no::surface{ no::asset_path("textures/" + name + ".png") });
+		return texture;
+	}
+	const int texture{ no::require_texture(name) };
+	texture_names[texture] = name;
+	return texture;
+}
+
+void release_texture(const std::string& name) {
+	if (!headless) {
+		no::release_texture(name);
+		return;
+	}
+	for (auto it{ texture_names.begin() }; it != texture_names.end(); ++it) {
+		if (it->second == name) {
+			texture_copies.erase(it->first);
+			texture_names.erase(it);
+			return;
+		}
+	}
+}
+
+int create_texture(const no::surface& surface) {
+	const int texture{ headless ? next_headless_texture++ : no::create_texture(surface) };
+	texture_copies[texture] = copy_pixels(surface);
+	return texture;
+}
+
+void delete_texture(int texture) {
+	texture_copies.erase(texture);
+	if (!headless) {
+		no::delete_texture(texture);
+	}
+}
+
+no::vector2i texture_size(int texture) {
+	if (!headless) {
+		return no::texture_size(texture);
+	}
+	if (const auto copy{ texture_copies.find(texture) }; copy != texture_copies.end()) {
+		return { copy->second.width, copy->second.height };
+	}
+	return {};
+}
+
+int require_shader(const std::string& name) {
+	return headless ? -1 : no::require_shader(name);
+}
+
+void release_shader(const std::string& name) {
+	if (!headless) {
+		no::release_shader(name);
+	}
+}
+
+void bind_shader(int shader) {
+	if (!software_target) {
+		no::bind_shader(shader);
+	}
+}
+
+void set_view_projection(const no::ortho_camera& camera) {
+	if (software_target) {
+		software_target->set_view(camera.transform.position, camera.size());
+	} else {
+		no::set_shader_view_projection(camera);
+	}
+}
+
+void set_model(const no::transform2& transform) {
+	current_model = transform;
+	if (!software_target) {
+		no::set_shader_model(transform);
+	}
+}
+
+void set_color(const no::vector4f& color) {
+	if (software_target) {
+		software_target->set_color(color);
+	} else {
+		no::get_shader_variable("color").set(color);
+	}
+}
+
+void bind_texture(int texture) {
+	if (software_target) {
+		upload_to_software_target(texture);
+		software_target->bind_texture(texture);
+	} else {
+		no::bind_texture(texture);
+	}
+}
+
+void draw_animation(const no::sprite_animation& animation, no::vector2f position, no::vector2f size, const no::vector4f& strip_uv) {
+	current_model = { position, size };
+	if (software_target) {
+		const no::vector4f first_frame{ strip_uv.x, strip_uv.y, strip_uv.z / static_cast<float>(std::max(animation.frames, 1)), strip_uv.w };
+		software_target->draw_quad(position, size, first_frame);
+	} else {
+		animation.draw(position, size);
+	}
+}
+
+}
+
+void textured_rectangle::set_tex_coords(const no::vector4f& new_uv) {
+	uv = new_uv;
+	if (shape) {
+		shape->set_tex_coords(uv.x, uv.y, uv.z, uv.w);
+	}
+}
+
+void textured_rectangle::draw(const no::transform2& transform) {
+	current_model = transform;
+	if (software_target) {
+		software_target->draw_quad(transform.position, transform.scale, uv);
+		return;
+	}
+	if (!shape) {
+		shape.emplace();
+		shape->set_tex_coords(uv.x, uv.y, uv.z, uv.w);
+	}
+	no::draw_shape(shape.value(), transform);
+}
+
+void quad_list::append(const no::sprite_vertex& top_left, const no::sprite_vertex& top_right, const no::sprite_vertex& bottom_right, const no::sprite_vertex& bottom_left) {
+	if (!headless) {
+		if (!shape) {
+			shape.emplace();
+		}
+		shape->append(top_left, top_right, bottom_right, bottom_left);
+	}
+	corners.push_back(top_left);
+	corners.push_back(bottom_right);
+}
+
+void quad_list::clear() {
+	if (shape) {
+		shape->clear();
+	}
+	corners.clear();
+}
+
+void quad_list::refresh() {
+	if (shape) {
+		shape->refresh();
+	}
+}
+
+bool quad_list::empty() const {
+	return corners.empty();
+}
+
+void quad_list::draw() const {
+	if (!software_target) {
+		if (shape) {
+			shape->bind();
+			shape->draw();
+		}
+		return;
+	}
+	for (size_t i{ 0 }; i < corners.size(); i += 2) {
+		const auto& top_left{ corners[i] };
+		const auto& bottom_right{ corners[i + 1] };
+		const no::vector2f position{ current_model.position + top_left.position * current_model.scale };
+		const no::vector2f size{ (bottom_right.position - top_left.position) * current_model.scale };
+		const no::vector2f uv_size{ bottom_right.tex_coords - top_left.tex_coords };
+		software_target->draw_quad(position, size, { top_left.tex_coords.x, top_left.tex_coords.y, uv_size.x, uv_size.y }, top_left.color);
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "draw.hpp"
+#include "camera.hpp"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+class software_renderer;
+
+// The game draws through these instead of calling the engine directly, so the same frame can also be drawn by the CPU rasteriser.
+// While a software target is set, draw calls go to it and not to the engine. Only used from the main thread.
+namespace draw_target {
+
+void set_software(software_renderer* target);
+
+// For batch runs before the window is opened. Nothing is sent to the engine while headless, so a software target must be set to draw.
+void set_headless(bool headless);
+
+// Textures and shaders are created and released through here as well, so the rasteriser can find their pixels.
+// While headless, textures are loaded straight from their files and get ids that only mean something here.
+int require_texture(const std::string& name);
+void release_texture(const std::string& name);
+int create_texture(const no::surface& surface);
+void delete_texture(int texture);
+no::vector2i texture_size(int texture);
+int require_shader(const std::string& name);
+void release_shader(const std::string& name);
+
+void bind_shader(int shader);
+void set_view_projection(const no::ortho_camera& camera);
+void set_model(const no::transform2& transform);
+void set_color(const no::vector4f& color);
+void bind_texture(int texture);
+
+// The strip is what was given to the animation's set_tex_coords(). The rasteriser draws its first frame.
+void draw_animation(const no::sprite_animation& animation, no::vector2f position, no::vector2f size, const no::vector4f& strip_uv);
+
+}
+
+// A rectangle that remembers its texture coordinates, since the engine's can't be read back and the rasteriser needs them.
+// The engine's rectangle is made the first time it's drawn through the engine.
+class textured_rectangle {
+public:
+
+	// Position and size in the texture, from 0 to 1.
+	void set_tex_coords(const no::vector4f& uv);
+
+	// Sets the model transform to the rectangle's.
+	void draw(const no::transform2& transform);
+
+private:
+
+	std::optional<no::rectangle> shape;
+	no::vector4f uv{ 0.0f, 0.0f, 1.0f, 1.0f };
+
+};
+
+// A quad array that also keeps the corners of its quads, so the rasteriser can draw it too. The quads must be axis-aligned.
+// The engine's quad array is only made when the list is filled while not headless.
+class quad_list {
+public:
+
+	void append(const no::sprite_vertex& top_left, const no::sprite_vertex& top_right, const no::sprite_vertex& bottom_right, const no::sprite_vertex& bottom_left);
+	void clear();
+	void refresh();
+	bool empty() const;
+
+	// Uses the model transform that is currently set.
+	void draw() const;
+
+private:
+
+	std::optional<no::quad_array<no::sprite_vertex, unsigned short>> shape;
+	std::vector<no::sprite_vertex> corners; // top left and bottom right of each quad
+
+};
@@ -0,0 +1,168 @@
+#include "frame_telemetry.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+long long now_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+float to_ms(long long ns) {
+	return static_cast<float>(static_cast<double>(ns) / 1000000.0);
+}
+
+}
+
+namespace frame_phase {
+
+const char* get_name(int phase) {
+	switch (phase) {
+	case update: return "Update";
+	case draw: return "Draw";
+	case swap: return "Swap";
+	case total: return "Total";
+	default: return "";
+	}
+}
+
+}
+
+frame_telemetry::scoped_timing::scoped_timing(frame_telemetry& telemetry, int phase) : telemetry{ telemetry }, phase{ phase }, start_ns{ now_ns() } {
+
+}
+
+frame_telemetry::scoped_timing::~scoped_timing() {
+	const long long end_ns{ now_ns() };
+	telemetry.add_time(phase, end_ns - start_ns);
+	if (phase == frame_phase::draw) {
+		telemetry.end_frame(end_ns);
+	}
+}
+
+frame_telemetry::frame_telemetry() {
+	sorted.reserve(rolling_frames);
+}
+
+frame_telemetry::~frame_telemetry() {
+	stop_csv();
+}
+
+frame_telemetry::scoped_timing frame_telemetry::measure_update() {
+	return { *this, frame_phase::update };
+}
+
+frame_telemetry::scoped_timing frame_telemetry::measure_draw() {
+	return { *this, frame_phase::draw };
+}
+
+void frame_telemetry::add_time(int phase, long long ns) {
+	pending_ns[phase] += ns;
+}
+
+void frame_telemetry::end_frame(long long end_ns) {
+	if (last_frame_end_ns < 0) {
+		last_frame_end_ns = end_ns;
+		std::fill(std::begin(pending_ns), std::end(pending_ns), 0);
+		return;
+	}
+	pending_ns[frame_phase::total] = end_ns - last_frame_end_ns;
+	pending_ns[frame_phase::swap] = std::max(0LL, pending_ns[frame_phase::total] - pending_ns[frame_phase::update] - pending_ns[frame_phase::draw]);
+	last_frame_end_ns = end_ns;
+	frame_sample sample;
+	sample.frame = frame_count++;
+	for (int phase{ 0 }; phase < frame_phase::total_phases; phase++) {
+		sample.ms[phase] = to_ms(pending_ns[phase]);
+		samples[phase][next_sample] = sample.ms[phase];
+		pending_ns[phase] = 0;
+	}
+	next_sample = (next_sample + 1) % rolling_frames;
+	sample_count = std::min(sample_count + 1, rolling_frames);
+	if (csv_running) {
+		std::lock_guard lock{ csv_mutex };
+		csv_queue.push_back(sample);
+		csv_condition.notify_one();
+	}
+}
+
+frame_telemetry::percentiles frame_telemetry::get_percentiles(int phase) const {
+	if (sample_count == 0) {
+		return {};
+	}
+	sorted.assign(samples[phase].begin(), samples[phase].begin() + sample_count);
+	std::sort(sorted.begin(), sorted.end());
+	const auto at{ [&](float percentile) {
+		return sorted[std::min(static_cast<int>(percentile * static_cast<float>(sample_count)), sample_count - 1)];
+	} };
+	return { at(0.5f), at(0.95f), at(0.99f), sorted.back() };
+}
+
+const float* frame_telemetry::history(int phase) const {
+	return samples[phase].data();
+}
+
+int frame_telemetry::history_offset() const {
+	return sample_count < rolling_frames ? 0 : next_sample;
+}
+
+int frame_telemetry::history_size() const {
+	return sample_count;
+}
+
+bool frame_telemetry::start_csv(const std::string& path) {
+	stop_csv();
+	csv_file.open(path);
+	if (!csv_file.is_open()) {
+		return false;
+	}
+	csv_file << "frame,update_ms,draw_ms,swap_ms,total_ms\n";
+	csv_running = true;
+	csv_thread = std::thread{ [this] {
+		write_csv();
+	} };
+	return true;
+}
+
+void frame_telemetry::stop_csv() {
+	if (!csv_thread.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard lock{ csv_mutex };
+		csv_running = false;
+	}
+	csv_condition.notify_one();
+	csv_thread.join();
+	csv_file.close();
+}
+
+bool frame_telemetry::is_writing_csv() const {
+	return csv_running;
+}
+
+void frame_telemetry::write_csv() {
+	std::unique_lock lock{ csv_mutex };
+	while (true) {
+		csv_condition.wait(lock, [this] {
+			return !csv_queue.empty() || !csv_running;
+		});
+		std::swap(csv_queue, csv_writing);
+		const bool running{ csv_running };
+		// Don't hold the game thread up while writing.
+		lock.unlock();
+		for (const auto& sample : csv_writing) {
+			csv_file << sample.frame;
+			for (const float ms : sample.ms) {
+				csv_file << ',' << ms;
+			}
+			csv_file << '\n';
+		}
+		csv_writing.clear();
+		csv_file.flush();
+		lock.lock();
+		if (!running && csv_queue.empty()) {
+			return;
+		}
+	}
+}
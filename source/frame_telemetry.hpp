@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace frame_phase {
+constexpr int update{ 0 };
+constexpr int draw{ 1 };
+constexpr int swap{ 2 }; // The rest of the frame: presenting, waiting for vsync and the loop itself.
+constexpr int total{ 3 };
+constexpr int total_phases{ 4 };
+
+const char* get_name(int phase);
+}
+
+// Keeps the time spent in each phase of the last frames, and optionally streams them to a CSV file on a background thread.
+class frame_telemetry {
+public:
+
+	static constexpr int rolling_frames{ 600 };
+
+	struct frame_sample {
+		long long frame{ 0 };
+		float ms[frame_phase::total_phases]{};
+	};
+
+	struct percentiles {
+		float p50{ 0.0f };
+		float p95{ 0.0f };
+		float p99{ 0.0f };
+		float max{ 0.0f };
+	};
+
+	class scoped_timing {
+	public:
+
+		scoped_timing(frame_telemetry& telemetry, int phase);
+		scoped_timing(const scoped_timing&) = delete;
+		scoped_timing(scoped_timing&&) = delete;
+		~scoped_timing();
+
+		scoped_timing& operator=(const scoped_timing&) = delete;
+		scoped_timing& operator=(scoped_timing&&) = delete;
+
+	private:
+
+		frame_telemetry& telemetry;
+		int phase{ 0 };
+		long long start_ns{ 0 };
+
+	};
+
+	frame_telemetry();
+	frame_telemetry(const frame_telemetry&) = delete;
+	frame_telemetry(frame_telemetry&&) = delete;
+	~frame_telemetry();
+
+	frame_telemetry& operator=(const frame_telemetry&) = delete;
+	frame_telemetry& operator=(frame_telemetry&&) = delete;
+
+	scoped_timing measure_update();
+
+	// The frame ends when the draw scope ends, and the time since the previous frame not spent updating or drawing is counted as swap.
+	scoped_timing measure_draw();
+
+	percentiles get_percentiles(int phase) const;
+
+	// Oldest first, for plotting.
+	const float* history(int phase) const;
+	int history_offset() const;
+	int history_size() const;
+
+	bool start_csv(const std::string& path);
+	void stop_csv();
+	bool is_writing_csv() const;
+
+private:
+
+	void add_time(int phase, long long ns);
+	void end_frame(long long end_ns);
+	void write_csv();
+
+	std::array<std::array<float, rolling_frames>, frame_phase::total_phases> samples{};
+	int next_sample{ 0 };
+	int sample_count{ 0 };
+	long long frame_count{ 0 };
+	long long pending_ns[frame_phase::total_phases]{};
+	long long last_frame_end_ns{ -1 };
+	mutable std::vector<float> sorted;
+
+	std::thread csv_thread;
+	std::mutex csv_mutex;
+	std::condition_variable csv_condition;
+	std::vector<frame_sample> csv_queue;
+	std::vector<frame_sample> csv_writing;
+	std::ofstream csv_file;
+	bool csv_running{ false };
+
+};
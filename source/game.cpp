@@ -4,23 +4,41 @@
 #include "imgui/imgui.h"
 #include "imgui/imgui_platform.h"
 #include "assets.hpp"
+#include "software_frame.hpp"
+#include "allocation_tracker.hpp"
+#include "profiler.hpp"
+#include "async_log.hpp"
+#include "benchmark.hpp"
+#include "command_line.hpp"
 #include <ctime>
 
 #define WITH_DEBUG_MENU 0
 
-game_state::game_state() : ui{ *this }, renderer{ *this }, controller{ *this }, intro_text{ *this, ui.camera }
-#if POST_LD_FEATURE_KILL_COUNT
-,kill_count_text{ *this, ui.camera }
-#endif
+game_state::game_state() : ui{ *this }, renderer{ *this }, stress{ *this }, controller{ *this }, intro_text{ *this, ui.camera }
 , instructions{ *this, ui.camera }
 {
+	async_log::start("log.html", "log.txt");
+	async_log::set_rate_limit(log_category::world, 30);
+	async_log::set_rate_limit(log_category::performance, 5);
+	LOG_INFO(log_category::general, "Game started");
 #if WITH_DEBUG_MENU
 	no::imgui::create(window());
 #endif
 	set_synchronization(no::draw_synchronization::if_updated);
 	window().set_swap_interval(no::swap_interval::immediate);
 	window().set_icon_from_resource(102);
-	bg_music = no::require_sound("bg");
+	stab_sound.load_ogg(no::asset_path("sounds/stab.ogg"));
+	magic_sound.load_ogg(no::asset_path("sounds/magic.ogg"));
+	magic2_sound.load_ogg(no::asset_path("sounds/magic2.ogg"));
+	if (music.open(no::asset_path("sounds/bg.ogg"))) {
+		mixer.set_music(&music);
+	}
+	// Without sound hardware, or with --audio-null, the mix is discarded. With --audio-wav[=path] it's written to a file.
+	if (const auto wav_path{ get_command_line_string("audio-wav") }) {
+		sound_output.start(audio_backend::wav_file, wav_path->empty() ? "audio.wav" : wav_path.value());
+	} else if (has_command_line_option("audio-null") || !sound_output.start()) {
+		sound_output.start(audio_backend::null);
+	}
 	cover_texture = no::require_texture("cover");
 	if (ui.font) {
 		intro_text.render(*ui.font, "Press any key to start playing!");
@@ -37,19 +55,38 @@ game_state::game_state() : ui{ *this }, renderer{ *this }, controller{ *this },
 		instructions.transform.scale *= 2.0f;
 		//
 	}
+	if (const auto csv_path{ get_command_line_string("telemetry-csv") }) {
+		// Frame times from the field, for when the debug menu isn't compiled in.
+		const std::string path{ csv_path->empty() ? "telemetry.csv" : csv_path.value() };
+		if (!telemetry.start_csv(path)) {
+			LOG_WARNING(log_category::performance, "Failed to open %s for frame telemetry", path.c_str());
+		}
+	}
+	if (has_command_line_option("benchmark")) {
+		// Batch run: write the results and quit without opening the game.
+		world_benchmark benchmark{ *this };
+		benchmark.run();
+		benchmark.write_csv("benchmark.csv");
+		// Exiting skips the destructors, so the WAV header must be finished here.
+		sound_output.stop();
+		async_log::stop();
+		std::exit(0);
+	}
+	if (has_command_line_option("stress")) {
+		stress.monsters_per_room = get_command_line_int("stress-monsters").value_or(stress.monsters_per_room);
+		stress.projectiles_per_room = get_command_line_int("stress-projectiles").value_or(stress.projectiles_per_room);
+		start_playing();
+		stress.start();
+	}
 	intro_listen_key = keyboard().press.listen([this](no::key key) {
 		if (show_intro) {
 			start_playing();
 		} else if (key == no::key::m) {
 			// POST-TWEAK: Let players toggle audio, instead of having to delete files.
 			play_audio = !play_audio;
-			if (play_audio) {
-				play_sound(bg_music);
-				bg_loop.start();
-			} else {
-				for (auto& audio_player : audio_players) {
-					audio_player->stop();
-				}
+			music.set_paused(!play_audio);
+			if (!play_audio) {
+				mixer.stop_all();
 			}
 			//
 		} else if (key == no::key::l) {
@@ -60,8 +97,6 @@ game_state::game_state() : ui{ *this }, renderer{ *this }, controller{ *this },
 		}
 	});
 	random_intro_dist_timer.start();
-	play_sound(bg_music);
-	bg_loop.start();
 }
 
 void game_state::start_playing() {
@@ -77,33 +112,25 @@ game_state::~game_state() {
 #if WITH_DEBUG_MENU
 	no::imgui::destroy();
 #endif
-	no::release_sound("bg");
 	no::release_texture("cover");
+	async_log::stop();
 }
 
-void game_state::play_sound(no::audio_source* sound) {
-	for (auto& audio_player : audio_players) {
-		if (!audio_player->is_playing()) {
-			audio_player->play(sound);
-			return;
-		}
+void game_state::play_sound(const sound_clip& sound, int priority) {
+	if (play_audio) {
+		mixer.play(sound, priority);
 	}
-	audio_players.emplace_back(audio().add_player())->play(sound);
 }
 
 void game_state::enter_lobby() {
-	world.rooms.clear();
-	world.player.room = nullptr;
+	world.clear_rooms();
 	world.is_boss_dead = false;
 	renderer.clear_rendered();
+	ui.clear_hit_splats();
 	generator.generate_lobby(world);
+	LOG_INFO(log_category::world, "Entered lobby");
 	set_background('l'); // POST-BUGFIX: Background wasn't set until going to next room.
-	for (auto& room : world.rooms) {
-		if (const auto position{ room.find_empty_position() }) {
-			world.player.transform.position = position.value();
-			break;
-		}
-	}
+	world.place_player();
 	world.player.stats.health = world.player.final_stats().max_health;
 	world.player.stats.mana = world.player.final_stats().max_mana;
 #if POST_LD_FEATURE_KILL_COUNT
@@ -112,19 +139,15 @@ void game_state::enter_lobby() {
 }
 
 void game_state::enter_dungeon(char type) {
-	world.rooms.clear();
-	world.player.room = nullptr;
+	world.clear_rooms();
 	world.is_boss_dead = false;
 	renderer.clear_rendered();
+	ui.clear_hit_splats();
 	generator.generate_dungeon(world, type);
 	set_background(type); // POST-BUGFIX: Background wasn't set until going to next room.
-	for (auto& room : world.rooms) {
-		if (const auto position{ room.find_empty_position() }) {
-			world.player.transform.position = position.value();
-			break;
-		}
-	}
+	world.place_player();
 	world.add_monsters();
+	LOG_INFO(log_category::world, "Entered dungeon '%c' with %i rooms", type, static_cast<int>(world.rooms.size()));
 #if POST_LD_FEATURE_KILL_COUNT
 	monster_count = 0;
 	kill_count = 0;
@@ -136,10 +159,8 @@ void game_state::enter_dungeon(char type) {
 }
 
 void game_state::update() {
-	if (bg_loop.milliseconds() > 42000) {
-		play_sound(bg_music);
-		bg_loop.start();
-	}
+	const auto update_timing{ telemetry.measure_update() };
+	allocation_tracker::next_frame();
 	if (show_intro) {
 		return;
 	}
@@ -158,6 +179,9 @@ void game_state::update() {
 		}
 		if (ImGui::MenuItem("Show all rooms", nullptr, &show_all_rooms)) {
 
+		}
+		if (ImGui::MenuItem("Simulation LOD", nullptr, &world.simulation_lod)) {
+
 		}
 		if (ImGui::MenuItem("Show collisions", nullptr, &show_collisions)) {
 
@@ -191,6 +215,12 @@ void game_state::update() {
 		if (ImGui::MenuItem("Zoom (5%)")) {
 			zoom = 0.05f;
 		}
+		if (ImGui::MenuItem("Render frame on CPU")) {
+			render_software_frame("software_frame.png");
+		}
+		if (!software_frame_result.empty()) {
+			ImGui::Text("%s", software_frame_result.c_str());
+		}
 		ImGui::PopItemWidth();
 		ImGui::EndMenu();
 	}
@@ -228,6 +258,78 @@ void game_state::update() {
 		ImGui::PopItemWidth();
 		ImGui::EndMenu();
 	}
+	if (ImGui::BeginMenu("Frame times")) {
+		ImGui::PushItemWidth(360.0f);
+		for (int phase{ 0 }; phase < frame_phase::total_phases; phase++) {
+			const auto times{ telemetry.get_percentiles(phase) };
+			ImGui::Text("%s: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms", frame_phase::get_name(phase), times.p50, times.p95, times.p99, times.max);
+		}
+		ImGui::PlotHistogram("Total (ms)", telemetry.history(frame_phase::total), telemetry.history_size(), telemetry.history_offset(), nullptr, 0.0f, 50.0f);
+		ImGui::Text("World events last frame:");
+		for (int type{ 0 }; type < world_event_type::total_types; type++) {
+			ImGui::Text("\t%s: %i", world_event_type::get_name(type), world_event_counts[type]);
+		}
+		bool writing_csv{ telemetry.is_writing_csv() };
+		if (ImGui::MenuItem("Write telemetry.csv", nullptr, &writing_csv)) {
+			if (writing_csv) {
+				telemetry.start_csv("telemetry.csv");
+			} else {
+				telemetry.stop_csv();
+			}
+		}
+		ImGui::PopItemWidth();
+		ImGui::EndMenu();
+	}
+	if (ImGui::BeginMenu("Stress test")) {
+		ImGui::PushItemWidth(360.0f);
+		ImGui::SliderInt("Monsters per room", &stress.monsters_per_room, 0, 5000);
+		ImGui::SliderInt("Projectiles per room", &stress.projectiles_per_room, 0, game_world_room::active_attack_pool::capacity);
+		if (stress.is_running()) {
+			if (ImGui::MenuItem("Stop")) {
+				stress.stop();
+			}
+		} else if (ImGui::MenuItem("Start")) {
+			stress.start();
+		}
+		if (!stress.report().empty()) {
+			ImGui::Text("%s", stress.report().c_str());
+		}
+		ImGui::PopItemWidth();
+		ImGui::EndMenu();
+	}
+	if (ImGui::BeginMenu("Benchmark")) {
+		ImGui::PushItemWidth(360.0f);
+		if (ImGui::MenuItem("Run world benchmarks")) {
+			world_benchmark benchmark{ *this };
+			benchmark.run();
+			benchmark.write_csv("benchmark.csv");
+			benchmark_results = benchmark.results();
+		}
+		for (const auto& result : benchmark_results) {
+			ImGui::Text("%s (n = %i): %.1f ns/op, scaling %.2f", result.name.c_str(), result.n, result.ns_per_operation, result.scaling);
+		}
+		ImGui::PopItemWidth();
+		ImGui::EndMenu();
+	}
+#if WITH_PROFILER
+	if (ImGui::BeginMenu("Profiler")) {
+		ImGui::PushItemWidth(360.0f);
+		bool recording{ profiler::is_recording() };
+		if (ImGui::MenuItem("Record zones", nullptr, &recording)) {
+			profiler::set_recording(recording);
+		}
+		if (ImGui::MenuItem("Export Chrome trace")) {
+			profiler::set_recording(false);
+			profiler::export_chrome_trace("profile_trace.json");
+		}
+		if (ImGui::MenuItem("Clear")) {
+			profiler::clear();
+		}
+		ImGui::Text("%i zones buffered", profiler::recorded_zones());
+		ImGui::PopItemWidth();
+		ImGui::EndMenu();
+	}
+#endif
 	ImGui::PushStyleColor(ImGuiCol_Text, 0xFF11EEEE);
 	ImGui::Text("\tFPS: %i", frame_counter().current_fps());
 	ImGui::PopStyleColor();
@@ -236,9 +338,33 @@ void game_state::update() {
 	ImGui::PopStyleColor();
 	ImGui::Text("\tPlayer Position: %s", CSTRING(world.player.transform.position));
 	if (world.player.room) {
-		ImGui::Text("\tActive Attacks: %i", static_cast<int>(world.player.room->attacks.size()));
-		ImGui::Text("\tHit Splats: %i", static_cast<int>(ui.splats.size()));
+		ImGui::Text("\tActive Attacks: %i (peak %i, %i dropped)", world.player.room->attacks.size(), world.player.room->attacks.peak_size(),
+			static_cast<int>(world.player.room->attacks.dropped_count()));
+		ImGui::Text("\tHit Splats: %i", ui.hit_splat_count());
+		ImGui::Text("\tMonsters: %i", static_cast<int>(world.player.room->monsters.size()));
+		ImGui::Text("\tRooms: %i full, %i reduced, %i dormant", world.rooms_in_tier(simulation_tier::full),
+			world.rooms_in_tier(simulation_tier::reduced), world.rooms_in_tier(simulation_tier::dormant));
+	}
+	ImGui::Text("\tSound Voices: %i/%i (%i stolen, %i dropped)", mixer.active_voices(), audio_mixer::max_voices,
+		static_cast<int>(mixer.stolen_voices()), static_cast<int>(mixer.dropped_sounds()));
+	ImGui::Text("\tAudio Output: %s, %i s mixed", audio_backend::get_name(sound_output.backend()), static_cast<int>(sound_output.mixed_frames() / audio_sample_rate));
+	ImGui::Text("\tMusic: %i loops, %i underruns", static_cast<int>(music.loops()), static_cast<int>(music.underruns()));
+	ImGui::Text("\tArena: %i KiB in %i allocations, %i from heap", static_cast<int>(world.arena.allocated_bytes() / 1024),
+		static_cast<int>(world.arena.allocations()), static_cast<int>(world.arena.heap_allocations()));
+	const auto& render_stats{ renderer.statistics };
+	ImGui::Text("\tChunks: %i/%i", render_stats.chunks_drawn, render_stats.chunks_drawn + render_stats.chunks_culled);
+	ImGui::Text("\tObjects: %i/%i", render_stats.objects_drawn, render_stats.objects_drawn + render_stats.objects_culled);
+	ImGui::Text("\tProjectiles: %i/%i", render_stats.attacks_drawn, render_stats.attacks_drawn + render_stats.attacks_culled);
+#if WITH_ALLOCATION_TRACKING
+	for (int subsystem{ allocation_subsystem::world }; subsystem < allocation_subsystem::total_subsystems; subsystem++) {
+		const auto allocations{ allocation_tracker::last_frame(subsystem) };
+		const bool over_budget{ allocation_tracker::budget(subsystem) >= 0 && allocations.allocations > allocation_tracker::budget(subsystem) };
+		ImGui::PushStyleColor(ImGuiCol_Text, over_budget ? 0xFF4444FF : 0xFFFFFFFF);
+		ImGui::Text("\t%s: %i allocs, %i B", allocation_subsystem::get_name(subsystem), static_cast<int>(allocations.allocations), static_cast<int>(allocations.bytes));
+		ImGui::PopStyleColor();
 	}
+	ImGui::Text("\tOver Budget: %i frames", static_cast<int>(allocation_tracker::frames_over_budget()));
+#endif
 	ImGui::EndMainMenuBar();
 	no::imgui::end_frame();
 #endif
@@ -247,17 +373,27 @@ void game_state::update() {
 		renderer.camera.transform.position.x -= keyboard().is_key_down(no::key::a) * 15.0f;
 		renderer.camera.transform.position.y += keyboard().is_key_down(no::key::s) * 15.0f;
 		renderer.camera.transform.position.x += keyboard().is_key_down(no::key::d) * 15.0f;
+	} else if (stress.is_running()) {
+		stress.update();
 	} else {
 		controller.update();
 	}
-	if (!world.player.locked_by_ui) {
+	// The bot ignores the chest window, so the stress test must not stop the world when one opens.
+	if (!world.player.locked_by_ui || stress.is_running()) {
+		allocation_scope scope{ allocation_subsystem::world };
 		world.update();
 	}
-	renderer.update();
+	handle_world_events();
+	{
+		allocation_scope scope{ allocation_subsystem::renderer };
+		renderer.update();
+	}
+	allocation_scope scope{ allocation_subsystem::ui };
 	ui.update();
 }
 
 void game_state::draw() {
+	const auto draw_timing{ telemetry.measure_draw() };
 	if (show_intro) {
 		renderer.camera.transform.scale = window().size().to<float>();
 		no::bind_shader(renderer.shader);
@@ -270,7 +406,7 @@ void game_state::draw() {
 		transform.scale.x = transform.scale.x * aspect_ratio;
 		transform.position.x = renderer.camera.transform.scale.x / 2.0f - transform.scale.x / 2.0f;
 		no::get_shader_variable("color").set(no::vector4f{ 1.0f });
-		no::draw_shape(renderer.rectangle, transform);
+		no::draw_shape(intro_rectangle, transform);
 
 		if (random_intro_dist_timer.milliseconds() > 100) {
 			random_intro_dist_1 = world.random.next<float>(-4.0f, 4.0f);
@@ -283,21 +419,21 @@ void game_state::draw() {
 		intro_text.transform.position.x = renderer.camera.transform.scale.x / 2.0f - intro_text.transform.scale.x / 2.0f;
 		intro_text.transform.position.y = 256.0f;
 		intro_text.transform.position -= 4.0f + random_intro_dist_1;
-		intro_text.draw(renderer.rectangle);
+		intro_text.draw(intro_rectangle);
 
 		// shadow
 		no::get_shader_variable("color").set(no::vector4f{ 0.2f, 0.2f, 0.2f, 1.0f });
 		intro_text.transform.position.x = renderer.camera.transform.scale.x / 2.0f - intro_text.transform.scale.x / 2.0f;
 		intro_text.transform.position.y = 256.0f;
 		intro_text.transform.position += 4.0f + random_intro_dist_2;
-		intro_text.draw(renderer.rectangle);
+		intro_text.draw(intro_rectangle);
 
 		// white
 		no::get_shader_variable("color").set(no::vector4f{ 1.0f });
 		intro_text.transform.position.x = renderer.camera.transform.scale.x / 2.0f - intro_text.transform.scale.x / 2.0f;
 		intro_text.transform.position.y = 256.0f;
 		intro_text.transform.position += random_intro_dist_1 / 2.0f;
-		intro_text.draw(renderer.rectangle);
+		intro_text.draw(intro_rectangle);
 
 		// POST-TWEAK: Show instructions!
 		// shadow
@@ -305,34 +441,92 @@ void game_state::draw() {
 		instructions.transform.position.x = renderer.camera.transform.scale.x / 2.5f - instructions.transform.scale.x / 2.0f;
 		instructions.transform.position.y = renderer.camera.transform.scale.y / 1.3f - instructions.transform.scale.y;
 		instructions.transform.position -= 4.0f;
-		instructions.draw(renderer.rectangle);
+		instructions.draw(intro_rectangle);
 		// shadow
 		no::get_shader_variable("color").set(no::vector4f{ 0.2f, 0.2f, 0.2f, 1.0f });
 		instructions.transform.position.x = renderer.camera.transform.scale.x / 2.5f - instructions.transform.scale.x / 2.0f;
 		instructions.transform.position.y = renderer.camera.transform.scale.y / 1.3f - instructions.transform.scale.y;
 		instructions.transform.position += 4.0f;
-		instructions.draw(renderer.rectangle);
+		instructions.draw(intro_rectangle);
 		// white
 		no::get_shader_variable("color").set(no::vector4f{ 1.0f });
 		instructions.transform.position.x = renderer.camera.transform.scale.x / 2.5f - instructions.transform.scale.x / 2.0f;
 		instructions.transform.position.y = renderer.camera.transform.scale.y / 1.3f - instructions.transform.scale.y;
-		instructions.draw(renderer.rectangle);
+		instructions.draw(intro_rectangle);
 		//
 		return;
 	}
-	renderer.draw();
-	ui.draw();
+	{
+		allocation_scope scope{ allocation_subsystem::renderer };
+		renderer.draw();
+	}
+	{
+		allocation_scope scope{ allocation_subsystem::ui };
+		ui.draw();
+	}
 #if WITH_DEBUG_MENU
 	no::imgui::draw();
 #endif
 }
 
+void game_state::render_software_frame(const std::string& output_path) {
+	const auto frame{ draw_software_frame(window().size(), background_color, world.jobs, [this] {
+		renderer.draw();
+		ui.draw();
+	}) };
+	frame.target.save_png(output_path);
+	software_frame_result = frame.summary();
+}
+
+void game_state::handle_world_events() {
+	for (int type{ 0 }; type < world_event_type::total_types; type++) {
+		world_event_counts[type] = world.events.count(type);
+	}
+	for (const auto& event : world.events) {
+		switch (event.type) {
+		case world_event_type::critical_hit:
+			ui.add_hit_splat(event.object_id);
+			break;
+		case world_event_type::kill:
+#if POST_LD_FEATURE_KILL_COUNT
+			kill_count++;
+#endif
+			break;
+		case world_event_type::boss_death:
+			LOG_INFO(log_category::world, "Boss killed, dropping item %i", event.value);
+			break;
+		case world_event_type::boss_reward:
+			ui.on_chest_open(event.value, true);
+			break;
+		case world_event_type::room_change:
+			set_background(static_cast<char>(event.value));
+			LOG_INFO(log_category::world, "Entered room of type '%c'", static_cast<char>(event.value));
+			break;
+		case world_event_type::attack_spawn:
+			if (event.by_player) {
+				if (item_type::is_staff(event.value)) {
+					play_sound(magic_sound, sound_priority::player);
+				} else {
+					play_sound(stab_sound, sound_priority::player);
+				}
+			} else {
+				if (monster_type::is_magic(event.value)) {
+					play_sound(magic2_sound, sound_priority::monster);
+				} else {
+					play_sound(stab_sound, sound_priority::monster);
+				}
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	world.events.clear();
+}
+
 void game_state::set_background(char type) {
-	if (type == 'f') {
-		window().set_clear_color({ 71.0f / 256.0f, 27.0f / 256.0f, 0.0f });
-	} else if (type == 'w') {
-		window().set_clear_color({ 0.0f, 36.0f / 256.0f, 71.0f / 256.0f });
-	} else if (type == 'l') {
-		window().set_clear_color({ 27.0f / 256.0f, 42.0f / 256.0f, 39.0f / 256.0f });
+	if (const auto color{ room_background_color(type) }) {
+		background_color = color.value();
+		window().set_clear_color(background_color);
 	}
 }
@@ -6,6 +6,12 @@
 #include "renderer.hpp"
 #include "generator.hpp"
 #include "game_ui.hpp"
+#include "frame_telemetry.hpp"
+#include "benchmark.hpp"
+#include "stress_test.hpp"
+#include "audio_mixer.hpp"
+#include "audio_output.hpp"
+#include "music_stream.hpp"
 
 class game_state;
 
@@ -19,7 +25,7 @@ public:
 	// However, it doesn't affect gameplay itself, and makes it  more enjoyable to play.
 	int kill_count{ 0 };
 	int monster_count{ 0 };
-	no::text_view kill_count_text;
+	std::string kill_count_text;
 	bool in_lobby{ false };
 	//
 #endif
@@ -34,6 +40,7 @@ public:
 
 	bool show_intro{ true };
 	int cover_texture{ -1 };
+	no::rectangle intro_rectangle;
 
 	void start_playing();
 
@@ -52,6 +59,8 @@ public:
 	game_world world;
 	game_ui ui;
 	game_renderer renderer;
+	frame_telemetry telemetry;
+	stress_test stress;
 
 	game_state();
 	~game_state() override;
@@ -64,17 +73,31 @@ public:
 	void enter_lobby();
 	void enter_dungeon(char type);
 
-	void play_sound(no::audio_source* sound);
+	void play_sound(const sound_clip& sound, int priority);
 
-	no::audio_source* bg_music{ nullptr };
-	std::vector<no::audio_player*> audio_players;
+	// Draws the current frame with the CPU rasteriser, through the same draw calls as draw().
+	void render_software_frame(const std::string& output_path);
+
+	// Music and sound effects are mixed by the game. The output is declared last, so it stops before what it plays is gone.
+	sound_clip stab_sound;
+	sound_clip magic_sound;
+	sound_clip magic2_sound;
+	music_stream music;
+	audio_mixer mixer;
+	audio_output sound_output{ mixer };
 
 private:
+
+	// Presents what the world did this frame: hit splats, kill count, dialogs, background and sounds.
+	void handle_world_events();
 	
 	bool limit_fps{ true };
 
 	player_controller controller;
 	game_world_generator generator;
-	no::timer bg_loop;
+	std::string software_frame_result;
+	no::vector3f background_color{};
+	std::vector<world_benchmark::result> benchmark_results;
+	int world_event_counts[world_event_type::total_types]{};
 
 };
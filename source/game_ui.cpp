@@ -3,6 +3,7 @@
 #include "window.hpp"
 #include "assets.hpp"
 #include "item.hpp"
+#include "profiler.hpp"
 
 namespace uv {
 
@@ -36,19 +37,23 @@ constexpr no::vector4f numbers[]{
 	{ 224.0f, 64.0f, 32.0f, 12.0f }
 };
 
-void set(no::rectangle& rectangle, const no::vector4f& uv) {
-	rectangle.set_tex_coords(uv.x / sheet_size.x, uv.y / sheet_size.y, uv.z / sheet_size.x, uv.w / sheet_size.y);
+void set(textured_rectangle& rectangle, const no::vector4f& uv) {
+	rectangle.set_tex_coords({ uv.x / sheet_size.x, uv.y / sheet_size.y, uv.z / sheet_size.x, uv.w / sheet_size.y });
 }
 
 }
 
-game_ui::game_ui(game_state& game) : game{ game }, 
-	stat_strength{ game, text_camera }, stat_attack_speed{ game, text_camera }, stat_critical{ game, text_camera },
-	stat_defense{ game, text_camera }, stat_speed{ game, text_camera }, stat_regen_health{ game, text_camera },
-	weapon_text{ game, text_camera }, chest_item_name{ game, text_camera }, chest_message{ game, text_camera } {
-	ui_texture = no::require_texture("ui");
+namespace text_color {
+constexpr uint32_t stat{ 0x00000000 };
+constexpr uint32_t normal{ 0xFFFFFFFF };
+}
+
+game_ui::game_ui(game_state& game) : game{ game } {
+	ui_texture = draw_target::require_texture("ui");
 	font = no::require_font("leo", 16);
-	critical_texture = no::create_texture(font->render("!", 0x000000FF));
+	text = std::make_unique<text_batch>(*font);
+	critical_texture = draw_target::create_texture(font->render("!", 0x000000FF));
+	critical_size = draw_target::texture_size(critical_texture).to<float>();
 }
 
 void game_ui::register_event_listeners() {
@@ -114,12 +119,14 @@ void game_ui::register_event_listeners() {
 }
 
 game_ui::~game_ui() {
-	no::delete_texture(critical_texture);
-	no::release_texture("ui");
+	text.reset();
+	draw_target::delete_texture(critical_texture);
+	draw_target::release_texture("ui");
 	no::release_font("leo", 16);
 }
 
 void game_ui::update() {
+	PROFILE_ZONE("game_ui::update");
 	// POST-BUGFIX: UI was partially hidden when window width was under 1600
 	if (camera.transform.scale.x > 1600.0f) {
 		camera.zoom = game.zoom;
@@ -129,39 +136,47 @@ void game_ui::update() {
 	//
 	camera.transform.scale = game.window().size().to<float>();
 	text_camera.transform.scale = game.window().size().to<float>();
-	uint32_t color{ 0x00000000 };
 	const auto stats{ game.world.player.final_stats() };
-	stat_strength.render(*font, std::to_string(static_cast<int>(stats.strength)), color);
-	stat_attack_speed.render(*font, std::to_string(static_cast<int>(stats.attack_speed)), color);
-	stat_critical.render(*font, std::to_string(static_cast<int>(stats.critical_strike_chance * 100.0f)) + "%", color);
-	stat_defense.render(*font, std::to_string(static_cast<int>(stats.defense)), color);
-	stat_speed.render(*font, std::to_string(static_cast<int>(stats.move_speed)), color);
-	stat_regen_health.render(*font, std::to_string(static_cast<int>(stats.health_regeneration_rate * 60.0f)) + "/s", color);
-	if (game.world.player.equipped_weapon() >= 0) {
-		weapon_text.render(*font, item_type::get_name(game.world.player.equipped_weapon()));
+	const int stat_values[6]{
+		static_cast<int>(stats.strength),
+		static_cast<int>(stats.attack_speed),
+		static_cast<int>(stats.critical_strike_chance * 100.0f),
+		static_cast<int>(stats.defense),
+		static_cast<int>(stats.move_speed),
+		static_cast<int>(stats.health_regeneration_rate * 60.0f)
+	};
+	// Only format the numbers when they change, to keep steady-state frames free of allocations.
+	for (int i{ 0 }; i < 6; i++) {
+		if (stat_values[i] == shown_stats[i] && !stat_text[i].empty()) {
+			continue;
+		}
+		shown_stats[i] = stat_values[i];
+		stat_text[i] = std::to_string(stat_values[i]);
+		if (i == 2) {
+			stat_text[i] += "%";
+		} else if (i == 5) {
+			stat_text[i] += "/s";
+		}
 	}
 	update_hit_splats();
 	if (chest_ui.open) {
-		chest_item_name.render(*font, item_type::get_name(chest_ui.item));
 		if (!game.world.is_boss_dead && (game.world.player.has_empty_slot() || item_type::is_weapon(chest_ui.item))) {
-			chest_message.render(*font, "Press 'Space' to take this item.\n\nAlternatively, press 'Escape' to close.");
+			chest_message = "Press 'Space' to take this item.\n\nAlternatively, press 'Escape' to close.";
 		} else if (!game.world.is_boss_dead) {
-			chest_message.render(*font, "Please press the digit of the slot to assign this item to.\nThe other item will be lost.\n\nAlternatively, press 'Escape' to close.");
+			chest_message = "Please press the digit of the slot to assign this item to.\nThe other item will be lost.\n\nAlternatively, press 'Escape' to close.";
 		} else {
 			// POST-TWEAK/FEATURE: Probably on the edge of being considered a "feature", but o'well.
 			if (chest_ui.item == item_type::fire_head || chest_ui.item == item_type::water_head) {
-				chest_message.render(*font, 
+				chest_message =
 					"You sure did him in, mate!\n"
 					"Here, take his head as a trophy.\n\n"
-					"Press 'Enter' or 'Escape' to go back to the lobby."
-				);
+					"Press 'Enter' or 'Escape' to go back to the lobby.";
 			} else {
-				chest_message.render(*font, 
+				chest_message =
 					"Wow! The final boss, defeated?!\n"
 					"I never expected anyone to accomplish such a thing.\n"
 					"Here, just take this dum- I mean, amazing \"Staff of Life\"!\n\n"
-					"Press 'Enter' or 'Escape' to go back to the lobby."
-				);
+					"Press 'Enter' or 'Escape' to go back to the lobby.";
 			}
 			//
 		}
@@ -171,87 +186,25 @@ void game_ui::update() {
 void game_ui::draw() {
 	auto& player{ game.world.player };
 
-	no::set_shader_view_projection(camera);
-	no::get_shader_variable("color").set(no::vector4f{ 1.0f });
-	no::bind_texture(ui_texture);
-
-	// draw overlay
-	uv::set(rectangle, uv::overlay);
-	no::draw_shape(rectangle, overlay_transform());
-
-	const auto player_stats{ player.final_stats() };
-
-	// draw health
-	if (player.stats.max_health > 1.0f) {
-		no::transform2 health_bar;
-		health_bar.position = overlay_transform().position + uv::bar_full.xy;
-		health_bar.scale = { 43.0f, 7.0f };
-		uv::set(rectangle, uv::bar_empty);
-		no::draw_shape(rectangle, health_bar);
-		health_bar.scale.x *= player_stats.health / player_stats.max_health;
-		uv::set(rectangle, uv::bar_full);
-		no::draw_shape(rectangle, health_bar);
-	}
+	draw_target::set_view_projection(camera);
+	draw_target::set_color(1.0f);
+	draw_target::bind_texture(ui_texture);
 
-	// draw mana
-	if (player.stats.max_mana > 1.0f) {
-		no::transform2 mana_bar;
-		mana_bar.position = overlay_transform().position + uv::bar_empty.xy;
-		mana_bar.scale = { 43.0f, 7.0f };
-		uv::set(rectangle, uv::bar_empty);
-		no::draw_shape(rectangle, mana_bar);
-		mana_bar.scale.x *= player_stats.mana / player_stats.max_mana;
-		uv::set(rectangle, uv::bar_full);
-		no::draw_shape(rectangle, mana_bar);
-	}
-
-	// draw items
-	for (int i = 0; i < 2; i++) {
-		no::transform2 transform;
-		transform.scale = 32.0f;
-		transform.position = overlay_transform().position;
-		transform.position.x += 224.0f;
-		transform.position.x += static_cast<float>(i) * 32.0f;
-		const auto item_transform{ transform };
-		uv::set(rectangle, uv::active_slot);
-		no::draw_shape(rectangle, transform);
-		transform.position.y += 32.0f;
-		transform.scale = uv::numbers[i].zw;
-		uv::set(rectangle, uv::numbers[i]);
-		no::draw_shape(rectangle, transform);
-		// draw item
-		uv::set(rectangle, item_type::get_uv(player.item_in_slot(i)));
-		no::draw_shape(rectangle, item_transform);
-	}
-	for (int i = 2; i < 8; i++) {
-		no::transform2 transform;
-		transform.scale = 32.0f;
-		transform.position = overlay_transform().position;
-		transform.position.x += 256.0f;
-		transform.position.x += static_cast<float>(i) * 32.0f;
-		const auto item_transform{ transform };
-		uv::set(rectangle, uv::slot);
-		no::draw_shape(rectangle, transform);
-		transform.position.y += 32.0f;
-		transform.scale = uv::numbers[i].zw;
-		uv::set(rectangle, uv::numbers[i]);
-		no::draw_shape(rectangle, transform);
-		// draw item
-		uv::set(rectangle, item_type::get_uv(player.item_in_slot(i)));
-		no::draw_shape(rectangle, item_transform);
+	// overlay, bars, item slots and the weapon icon are retained, and only rebuilt when they change
+	const auto state{ current_draw_list_state() };
+	if (!(state == draw_list_state)) {
+		draw_list_state = state;
+		rebuild_draw_list();
 	}
+	draw_target::set_model(no::transform2{ 0.0f, 1.0f });
+	draw_list.draw();
 
-	// draw weapon icon, bottom right
 	if (player.equipped_weapon() >= 0) {
-		no::transform2 weapon_transform;
-		weapon_transform.position = camera.size() - 96.0f;
-		weapon_transform.scale = 64.0f;
-		uv::set(rectangle, item_type::get_uv(player.equipped_weapon()));
-		no::draw_shape(rectangle, weapon_transform);
-		weapon_text.transform.position = weapon_transform.position;
-		weapon_text.transform.position.x += weapon_transform.scale.x / 2.0f - weapon_text.transform.scale.x / 2.0f;
-		weapon_text.transform.position.y += weapon_transform.scale.y;
-		weapon_text.draw(static_rectangle);
+		const auto weapon_name{ item_type::get_name(player.equipped_weapon()) };
+		no::vector2f weapon_text_position{ weapon_transform().position };
+		weapon_text_position.x += weapon_transform().scale.x / 2.0f - text->size_of(weapon_name).x / 2.0f;
+		weapon_text_position.y += weapon_transform().scale.y;
+		text->add(weapon_name, text_color::normal, weapon_text_position * camera.zoom, camera.zoom);
 	}
 
 	// draw chest ui
@@ -260,60 +213,46 @@ void game_ui::draw() {
 		chest_ui_transform.scale = { 320.0f, 192.0f };
 		chest_ui_transform.position = camera.size() / 2.0f - chest_ui_transform.scale / 2.0f;
 		// draw background
-		no::bind_texture(game.renderer.blank_texture);
-		no::get_shader_variable("color").set(no::vector4f{ 0.4f, 0.4f, 0.4f, 0.8f });
-		no::draw_shape(static_rectangle, chest_ui_transform);
-		no::get_shader_variable("color").set(no::vector4f{ 1.0f });
+		draw_target::bind_texture(game.renderer.blank_texture);
+		draw_target::set_color({ 0.4f, 0.4f, 0.4f, 0.8f });
+		static_rectangle.draw(chest_ui_transform);
+		draw_target::set_color(1.0f);
 		// draw item
-		no::bind_texture(ui_texture);
+		draw_target::bind_texture(ui_texture);
 		uv::set(rectangle, item_type::get_uv(chest_ui.item));
 		no::transform2 item_transform;
 		item_transform.position = chest_ui_transform.position + 16.0f;
 		item_transform.scale = 32.0f;
-		no::draw_shape(rectangle, item_transform);
-		chest_item_name.transform.position = { chest_ui_transform.position.x + 64.0f, chest_ui_transform.position.y + 32.0f };
-		chest_item_name.draw(static_rectangle);
-
-		no::set_shader_view_projection(text_camera);
-		chest_message.transform.position = { chest_ui_transform.position.x + 64.0f, chest_ui_transform.position.y + 64.0f };
-		chest_message.transform.position *= game.zoom;
-		chest_message.draw(static_rectangle);
+		rectangle.draw(item_transform);
+		const no::vector2f item_name_position{ chest_ui_transform.position.x + 64.0f, chest_ui_transform.position.y + 32.0f };
+		text->add(item_type::get_name(chest_ui.item), text_color::normal, item_name_position * camera.zoom, camera.zoom);
+		const no::vector2f message_position{ chest_ui_transform.position.x + 64.0f, chest_ui_transform.position.y + 64.0f };
+		text->add(chest_message, text_color::normal, message_position * game.zoom);
 	}
 
 #if POST_LD_FEATURE_KILL_COUNT
 	if (!game.in_lobby) {
-		no::set_shader_view_projection(text_camera);
-		game.kill_count_text.render(*font, STRING("You've killed " << game.kill_count << "/" << game.monster_count << " monsters in this dungeon"));
-		game.kill_count_text.transform.position = { 32.0f, camera.transform.scale.y - 96.0f };
-		game.kill_count_text.draw(static_rectangle);
+		if (game.kill_count != shown_kill_count || game.monster_count != shown_monster_count) {
+			shown_kill_count = game.kill_count;
+			shown_monster_count = game.monster_count;
+			game.kill_count_text = STRING("You've killed " << game.kill_count << "/" << game.monster_count << " monsters in this dungeon");
+		}
+		text->add(game.kill_count_text, text_color::normal, { 32.0f, camera.transform.scale.y - 96.0f });
 	}
 #endif
 
 	// draw stat numbers
-	no::set_shader_view_projection(text_camera);
-	no::vector2f stat;
-	stat = { 114.0f, 8.0f };
-	stat += overlay_transform().position;
-	stat_strength.transform.position = stat * camera.zoom;
-	stat_strength.draw(static_rectangle);
-	stat.x += 32.0f;
-	stat_attack_speed.transform.position = stat * camera.zoom;
-	stat_attack_speed.draw(static_rectangle);
-	stat.x += 32.0f;
-	stat_critical.transform.position = stat * camera.zoom;
-	stat_critical.draw(static_rectangle);
-	stat = { 114.0f, 22.0f };
-	stat += overlay_transform().position;
-	stat_defense.transform.position = stat * camera.zoom;
-	stat_defense.draw(static_rectangle);
-	stat.x += 32.0f;
-	stat_speed.transform.position = stat * camera.zoom;
-	stat_speed.draw(static_rectangle);
-	stat.x += 32.0f;
-	stat_regen_health.transform.position = stat * camera.zoom;
-	stat_regen_health.draw(static_rectangle);
-
-	no::set_shader_view_projection(game.renderer.camera);
+	for (int i{ 0 }; i < 6; i++) {
+		no::vector2f stat{ 114.0f + static_cast<float>(i % 3) * 32.0f, i < 3 ? 8.0f : 22.0f };
+		stat += overlay_transform().position;
+		text->add(stat_text[i], text_color::stat, stat * camera.zoom);
+	}
+
+	// all text is drawn in one pass
+	draw_target::set_view_projection(text_camera);
+	text->draw();
+
+	draw_target::set_view_projection(game.renderer.camera);
 	draw_hit_splats();
 }
 
@@ -332,6 +271,102 @@ void game_ui::on_chest_open(int item, bool force) {
 	chest_ui.open = true;
 }
 
+game_ui::ui_draw_list_state game_ui::current_draw_list_state() const {
+	const auto& player{ game.world.player };
+	const auto player_stats{ player.final_stats() };
+	ui_draw_list_state state;
+	for (int i{ 0 }; i < 8; i++) {
+		state.items[i] = player.item_in_slot(i);
+	}
+	state.weapon = player.equipped_weapon();
+	// Bars are compared by their width in screen pixels, so regeneration does not rebuild the list every frame.
+	// Health goes below zero while the player is dying, which should show as an empty bar.
+	state.show_health = player.stats.max_health > 1.0f;
+	if (state.show_health) {
+		state.health_width = static_cast<int>(bar_size.x * camera.zoom * std::max(0.0f, player_stats.health) / player_stats.max_health);
+	}
+	state.show_mana = player.stats.max_mana > 1.0f;
+	if (state.show_mana) {
+		state.mana_width = static_cast<int>(bar_size.x * camera.zoom * std::max(0.0f, player_stats.mana) / player_stats.max_mana);
+	}
+	state.camera_size = camera.size();
+	return state;
+}
+
+void game_ui::rebuild_draw_list() {
+	draw_list.clear();
+
+	// overlay
+	append_quad(overlay_transform(), uv::overlay);
+
+	// health
+	if (draw_list_state.show_health) {
+		no::transform2 health_bar;
+		health_bar.position = overlay_transform().position + uv::bar_full.xy;
+		health_bar.scale = bar_size;
+		append_quad(health_bar, uv::bar_empty);
+		health_bar.scale.x = static_cast<float>(draw_list_state.health_width) / camera.zoom;
+		append_quad(health_bar, uv::bar_full);
+	}
+
+	// mana
+	if (draw_list_state.show_mana) {
+		no::transform2 mana_bar;
+		mana_bar.position = overlay_transform().position + uv::bar_empty.xy;
+		mana_bar.scale = bar_size;
+		append_quad(mana_bar, uv::bar_empty);
+		mana_bar.scale.x = static_cast<float>(draw_list_state.mana_width) / camera.zoom;
+		append_quad(mana_bar, uv::bar_full);
+	}
+
+	// items
+	for (int i{ 0 }; i < 8; i++) {
+		no::transform2 transform;
+		transform.scale = 32.0f;
+		transform.position = overlay_transform().position;
+		transform.position.x += i < 2 ? 224.0f : 256.0f;
+		transform.position.x += static_cast<float>(i) * 32.0f;
+		const auto item_transform{ transform };
+		append_quad(transform, i < 2 ? uv::active_slot : uv::slot);
+		transform.position.y += 32.0f;
+		transform.scale = uv::numbers[i].zw;
+		append_quad(transform, uv::numbers[i]);
+		append_quad(item_transform, item_type::get_uv(draw_list_state.items[i]));
+	}
+
+	// weapon icon, bottom right
+	if (draw_list_state.weapon >= 0) {
+		append_quad(weapon_transform(), item_type::get_uv(draw_list_state.weapon));
+	}
+
+	draw_list.refresh();
+}
+
+void game_ui::append_quad(const no::transform2& transform, const no::vector4f& uv) {
+	const no::vector2f uv_1{ uv.xy / uv::sheet_size };
+	const no::vector2f uv_2{ (uv.xy + uv.zw) / uv::sheet_size };
+	no::sprite_vertex top_left;
+	no::sprite_vertex top_right;
+	no::sprite_vertex bottom_right;
+	no::sprite_vertex bottom_left;
+	top_left.position = transform.position;
+	top_right.position = { transform.position.x + transform.scale.x, transform.position.y };
+	bottom_right.position = transform.position + transform.scale;
+	bottom_left.position = { transform.position.x, transform.position.y + transform.scale.y };
+	top_left.tex_coords = uv_1;
+	top_right.tex_coords = { uv_2.x, uv_1.y };
+	bottom_right.tex_coords = uv_2;
+	bottom_left.tex_coords = { uv_1.x, uv_2.y };
+	draw_list.append(top_left, top_right, bottom_right, bottom_left);
+}
+
+no::transform2 game_ui::weapon_transform() const {
+	no::transform2 transform;
+	transform.position = camera.size() - 96.0f;
+	transform.scale = 64.0f;
+	return transform;
+}
+
 no::transform2 game_ui::overlay_transform() const {
 	no::transform2 transform;
 	transform.position = 16.0f;
@@ -340,7 +375,29 @@ no::transform2 game_ui::overlay_transform() const {
 }
 
 void game_ui::add_hit_splat(int target_id) {
-	splats.emplace_back().target_id = target_id;
+	int index{ splat_count };
+	if (splat_count < max_hit_splats) {
+		splat_count++;
+	} else {
+		// the pool is full, so replace the splat that is furthest into fading out
+		index = 0;
+		for (int i{ 1 }; i < splat_count; i++) {
+			if (splats[i].fade_out > splats[index].fade_out) {
+				index = i;
+			}
+		}
+	}
+	splats[index] = {};
+	splats[index].target = game.world.handle_of(target_id);
+	splats[index].transform.scale = critical_size;
+}
+
+void game_ui::clear_hit_splats() {
+	splat_count = 0;
+}
+
+int game_ui::hit_splat_count() const {
+	return splat_count;
 }
 
 void game_ui::update_hit_splats() {
@@ -349,7 +406,7 @@ void game_ui::update_hit_splats() {
 		return;
 	}
 	//
-	for (int i{ 0 }; i < static_cast<int>(splats.size()); i++) {
+	for (int i{ 0 }; i < splat_count; i++) {
 		auto& splat{ splats[i] };
 		if (splat.fade_in < 1.0f) {
 			splat.fade_in += 0.04f;
@@ -361,30 +418,53 @@ void game_ui::update_hit_splats() {
 			splat.fade_out += 0.05f;
 			splat.alpha = 1.0f - splat.fade_out;
 		}
-		if (splat.target_id != -1) {
-			if (auto target{ game.world.player.room->object_with_id(splat.target_id) }) {
-				no::vector2f position = target->transform.position;
-				splat.transform.position = position + 16.0f;
-				splat.transform.position.y -= (splat.fade_in * 0.5f + splat.fade_out) * 32.0f;
-			}
+		if (const auto target{ game.world.find_object(splat.target) }) {
+			splat.transform.position = target->transform.position + 16.0f;
+			splat.transform.position.y -= (splat.fade_in * 0.5f + splat.fade_out) * 32.0f;
 		}
-		splat.transform.scale = no::texture_size(critical_texture).to<float>();
 		if (!splat.is_visible()) {
-			splats.erase(splats.begin() + i);
+			splats[i] = splats[splat_count - 1];
+			splat_count--;
 			i--;
 		}
 	}
 }
 
 void game_ui::draw_hit_splats() {
-	auto color{ no::get_shader_variable("color") };
-	for (auto& splat : splats) {
-		auto shadow{ splat.transform };
-		shadow.position += 1.0f;
-		no::bind_texture(critical_texture);
-		color.set({ 0.0f, 0.0f, 0.0f, splat.alpha });
-		no::draw_shape(static_rectangle, shadow);
-		color.set({ 1.0f, 1.0f, 1.0f, splat.alpha });
-		no::draw_shape(static_rectangle, splat.transform);
+	if (splat_count == 0) {
+		return;
+	}
+	splat_shape.clear();
+	no::sprite_vertex top_left;
+	no::sprite_vertex top_right;
+	no::sprite_vertex bottom_right;
+	no::sprite_vertex bottom_left;
+	top_left.tex_coords = { 0.0f, 0.0f };
+	top_right.tex_coords = { 1.0f, 0.0f };
+	bottom_right.tex_coords = { 1.0f, 1.0f };
+	bottom_left.tex_coords = { 0.0f, 1.0f };
+	for (int i{ 0 }; i < splat_count; i++) {
+		const auto& splat{ splats[i] };
+		// shadow first, then the splat itself
+		for (int layer{ 0 }; layer < 2; layer++) {
+			const no::vector2f position{ layer == 0 ? splat.transform.position + 1.0f : splat.transform.position };
+			const no::vector2f size{ splat.transform.scale };
+			const float shade{ layer == 0 ? 0.0f : 1.0f };
+			const no::vector4f color{ shade, shade, shade, splat.alpha };
+			top_left.position = position;
+			top_right.position = { position.x + size.x, position.y };
+			bottom_right.position = position + size;
+			bottom_left.position = { position.x, position.y + size.y };
+			top_left.color = color;
+			top_right.color = color;
+			bottom_right.color = color;
+			bottom_left.color = color;
+			splat_shape.append(top_left, top_right, bottom_right, bottom_left);
+		}
 	}
+	splat_shape.refresh();
+	draw_target::bind_texture(critical_texture);
+	draw_target::set_color(1.0f);
+	draw_target::set_model(no::transform2{ 0.0f, 1.0f });
+	splat_shape.draw();
 }
@@ -1,17 +1,22 @@
 #pragma once
 
 #include "draw.hpp"
+#include "draw_target.hpp"
 #include "camera.hpp"
 #include "font.hpp"
 #include "ui.hpp"
 #include "event.hpp"
+#include "text_batch.hpp"
+#include "world.hpp"
+
+#include <array>
 
 class game_state;
 
 struct critical_hit_splat {
 
 	no::transform2 transform;
-	int target_id{ -1 };
+	object_handle target;
 	float fade_in{ 0.0f };
 	float stay{ 0.0f };
 	float fade_out{ 0.0f };
@@ -28,7 +33,8 @@ public:
 	no::ortho_camera camera;
 	no::ortho_camera text_camera;
 
-	std::vector<critical_hit_splat> splats;
+	static constexpr int max_hit_splats{ 128 };
+
 	no::font* font;
 
 	game_ui(game_state& game);
@@ -39,6 +45,8 @@ public:
 
 	void on_chest_open(int item, bool force = false);
 	void add_hit_splat(int target_id);
+	void clear_hit_splats();
+	int hit_splat_count() const;
 
 	void register_event_listeners();
 
@@ -48,28 +56,57 @@ private:
 		bool open{ false };
 		int item{ -1 };
 	} chest_ui;
-	no::text_view chest_item_name;
-	no::text_view chest_message;
+	std::string chest_message;
+
+	int shown_stats[6]{};
+	int shown_kill_count{ -1 };
+	int shown_monster_count{ -1 };
+
+	struct ui_draw_list_state {
+		int items[8]{};
+		int weapon{ -1 };
+		bool show_health{ false };
+		bool show_mana{ false };
+		int health_width{ 0 };
+		int mana_width{ 0 };
+		no::vector2f camera_size;
+
+		bool operator==(const ui_draw_list_state& that) const {
+			return std::equal(std::begin(items), std::end(items), std::begin(that.items)) && weapon == that.weapon
+				&& show_health == that.show_health && show_mana == that.show_mana
+				&& health_width == that.health_width && mana_width == that.mana_width && camera_size == that.camera_size;
+		}
+
+	};
+
+	static constexpr no::vector2f bar_size{ 43.0f, 7.0f };
+
+	ui_draw_list_state draw_list_state;
+	quad_list draw_list;
+
+	ui_draw_list_state current_draw_list_state() const;
+	void rebuild_draw_list();
+	void append_quad(const no::transform2& transform, const no::vector4f& uv);
 
 	no::transform2 overlay_transform() const;
+	no::transform2 weapon_transform() const;
 	void update_hit_splats();
 	void draw_hit_splats();
 
 	game_state& game;
 
 	int ui_texture{ -1 };
-	no::rectangle rectangle;
+	textured_rectangle rectangle;
 	int critical_texture{ -1 };
+	no::vector2f critical_size;
+
+	std::array<critical_hit_splat, max_hit_splats> splats;
+	int splat_count{ 0 };
+	quad_list splat_shape;
 	
-	no::rectangle static_rectangle;
-	no::text_view stat_strength;
-	no::text_view stat_attack_speed;
-	no::text_view stat_critical;
-	no::text_view stat_defense;
-	no::text_view stat_speed;
-	no::text_view stat_regen_health;
-
-	no::text_view weapon_text;
+	textured_rectangle static_rectangle;
+	std::unique_ptr<text_batch> text;
+	std::string stat_text[6];
 
 	no::event_listener key_press;
 
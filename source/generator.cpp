@@ -5,6 +5,11 @@ game_world_generator::game_world_generator() {
 	no::set_noise_seed(random.seed());
 }
 
+void game_world_generator::set_seed(int seed) {
+	random = no::random_number_generator{ seed };
+	no::set_noise_seed(random.seed());
+}
+
 void game_world_generator::generate_dungeon(game_world& world, char type) {
 	world.is_lobby = false;
 	generating_lobby = false;
@@ -61,8 +66,7 @@ void game_world_generator::make_tile(game_world_room& room, game_world_tile& til
 
 void game_world_generator::make_room(game_world& world, char room_type) {
 	int direction{ next_room_direction() };
-	auto& room{ world.rooms.emplace_back() };
-	room.world = &world;
+	auto& room{ world.rooms.emplace_back(world) };
 	room.type = room_type;
 	if (direction > 0 && horizontal_since_vertical_change > 0) {
 		place_room_top(world, room);
@@ -119,6 +123,7 @@ void game_world_generator::make_room(game_world& world, char room_type) {
 			}
 		}
 	}
+	room.build_spawn_tiles();
 	world_size.x = room.index.x + room.width();
 	world_size.y = room.index.y + room.height();
 	last_world_size_delta = { room.width(), room.height() };
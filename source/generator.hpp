@@ -12,6 +12,9 @@ public:
 	void generate_dungeon(game_world& world, char type);
 	void generate_lobby(game_world& world);
 
+	// The same seed gives the same rooms.
+	void set_seed(int seed);
+
 private:
 
 	void make_tile(game_world_room& room, game_world_tile& tile, int x, int y);
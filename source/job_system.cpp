@@ -0,0 +1,119 @@
+#include "job_system.hpp"
+#include "allocation_tracker.hpp"
+
+#include <algorithm>
+
+job_system::job_system() : job_system{ std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1) } {
+
+}
+
+job_system::job_system(int worker_count) : queues{ std::make_unique<job_queue[]>(worker_count + 1) }, queue_count{ worker_count + 1 } {
+	workers.reserve(worker_count);
+	for (int i{ 0 }; i < worker_count; i++) {
+		workers.emplace_back([this, i] {
+			run_worker(i);
+		});
+	}
+}
+
+job_system::~job_system() {
+	{
+		std::lock_guard lock{ wake_mutex };
+		stopping = true;
+	}
+	wake_condition.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+void job_system::parallel_for(int count, const std::function<void(int)>& job) {
+	if (count <= 0) {
+		return;
+	}
+	if (workers.empty() || count == 1) {
+		for (int i{ 0 }; i < count; i++) {
+			job(i);
+		}
+		return;
+	}
+	// Set before any index is queued, since a worker still finishing the previous loop may pick it up right away.
+	current_job = &job;
+	current_subsystem = allocation_tracker::current_subsystem();
+	remaining = count;
+	for (int i{ 0 }; i < queue_count; i++) {
+		std::lock_guard lock{ queues[i].mutex };
+		queues[i].indices.clear();
+		queues[i].front = 0;
+	}
+	// Spread the indices round-robin, so neighbouring rooms of similar cost end up on different threads.
+	for (int i{ 0 }; i < count; i++) {
+		auto& queue{ queues[i % queue_count] };
+		std::lock_guard lock{ queue.mutex };
+		queue.indices.push_back(i);
+	}
+	{
+		std::lock_guard lock{ wake_mutex };
+		generation++;
+	}
+	wake_condition.notify_all();
+	work(queue_count - 1);
+	while (remaining.load(std::memory_order_acquire) > 0) {
+		std::this_thread::yield();
+	}
+	current_job = nullptr;
+}
+
+int job_system::thread_count() const {
+	return queue_count;
+}
+
+bool job_system::pop(int queue_index, int& index) {
+	auto& queue{ queues[queue_index] };
+	std::lock_guard lock{ queue.mutex };
+	if (queue.front >= static_cast<int>(queue.indices.size())) {
+		return false;
+	}
+	index = queue.indices.back();
+	queue.indices.pop_back();
+	return true;
+}
+
+bool job_system::steal(int thief_index, int& index) {
+	for (int offset{ 1 }; offset < queue_count; offset++) {
+		auto& queue{ queues[(thief_index + offset) % queue_count] };
+		std::lock_guard lock{ queue.mutex };
+		if (queue.front < static_cast<int>(queue.indices.size())) {
+			index = queue.indices[queue.front];
+			queue.front++;
+			return true;
+		}
+	}
+	return false;
+}
+
+void job_system::work(int queue_index) {
+	int index{ 0 };
+	while (pop(queue_index, index) || steal(queue_index, index)) {
+		allocation_scope scope{ current_subsystem.load(std::memory_order_acquire) };
+		(*current_job.load(std::memory_order_acquire))(index);
+		remaining.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+void job_system::run_worker(int queue_index) {
+	long long seen_generation{ 0 };
+	while (true) {
+		{
+			std::unique_lock lock{ wake_mutex };
+			wake_condition.wait(lock, [&] {
+				return stopping || generation != seen_generation;
+			});
+			if (stopping) {
+				return;
+			}
+			seen_generation = generation;
+		}
+		work(queue_index);
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs the iterations of a loop on a pool of worker threads. Each thread has its own queue of indices,
+// takes from the back of it, and steals from the front of the others when it runs out.
+class job_system {
+public:
+
+	// Uses one thread less than the hardware has, since the calling thread works too.
+	job_system();
+	job_system(int worker_count);
+	job_system(const job_system&) = delete;
+	job_system(job_system&&) = delete;
+	~job_system();
+
+	job_system& operator=(const job_system&) = delete;
+	job_system& operator=(job_system&&) = delete;
+
+	// Calls the job for every index in [0, count) and returns when all are done. Not reentrant.
+	// Allocations in the job are attributed to the subsystem of the calling thread, also on the workers.
+	void parallel_for(int count, const std::function<void(int)>& job);
+
+	int thread_count() const;
+
+private:
+
+	struct job_queue {
+		std::mutex mutex;
+		std::vector<int> indices;
+		int front{ 0 };
+	};
+
+	bool pop(int queue_index, int& index);
+	bool steal(int thief_index, int& index);
+	void work(int queue_index);
+	void run_worker(int queue_index);
+
+	std::vector<std::thread> workers;
+	std::unique_ptr<job_queue[]> queues; // One per worker, and the last for the calling thread.
+	int queue_count{ 0 };
+
+	std::mutex wake_mutex;
+	std::condition_variable wake_condition;
+	long long generation{ 0 };
+	bool stopping{ false };
+
+	std::atomic<const std::function<void(int)>*> current_job{ nullptr };
+	std::atomic<int> current_subsystem{ 0 };
+	std::atomic<int> remaining{ 0 };
+
+};
@@ -454,19 +454,20 @@ monster_object::monster_object(int type) : type{ type } {
 	}
 }
 
-void monster_object::update() {
+void monster_object::update(int ticks) {
+	const float elapsed_seconds{ static_cast<float>(ticks) / static_cast<float>(ticks_per_second) };
 	if (dead) {
 		if (!animation.is_done()) {
-			animation.update(1.0f / 60.0f);
+			animation.update(elapsed_seconds);
 		} else if (last_animation != animation_type::die) {
 			set_die_animation(); // POST-BUGFIX: Delay die animation until hit-flash has shown.
 		} else if (animation.is_done() && last_animation == animation_type::die) {
 			if (type == monster_type::fire_boss) {
-				world->game->ui.on_chest_open(item_type::fire_head, true);
+				room->pending_events.push({ world_event_type::boss_reward, id, item_type::fire_head, false, transform.position });
 			} else if (type == monster_type::water_boss) {
-				world->game->ui.on_chest_open(item_type::water_head, true);
+				room->pending_events.push({ world_event_type::boss_reward, id, item_type::water_head, false, transform.position });
 			} else if (type == monster_type::final_boss) {
-				world->game->ui.on_chest_open(item_type::staff_of_life, true);
+				room->pending_events.push({ world_event_type::boss_reward, id, item_type::staff_of_life, false, transform.position });
 			}
 		}
 		return;
@@ -490,20 +491,30 @@ void monster_object::update() {
 			set_idle_animation();
 		}
 	}
-	if (type != monster_type::fire_boss && type != monster_type::water_boss && type != monster_type::final_boss) {
+	// Monsters in other rooms, or catching up on time the player wasn't there for, don't know where the player is.
+	const bool aware_of_player{ room == world->player.room && !room->catching_up };
+	if (aware_of_player && type != monster_type::fire_boss && type != monster_type::water_boss && type != monster_type::final_boss) {
 		const auto player_collision{ world->player.collision_transform() };
 		const auto monster_collision{ collision_transform() };
 		distance_to_player = player_collision.position.distance_to(monster_collision.position + monster_collision.scale / 2.0f);
-		if (distance_to_player < tile_size_f * 5.0f && distance_to_player > tile_size_f * 0.75f && become_angry_timer.seconds() > 1) {
+		const bool is_chasing{ distance_to_player < tile_size_f * 5.0f && distance_to_player > tile_size_f * 0.75f && become_angry_timer.seconds() > 1 };
+		const no::vector2i flow{ is_chasing ? room->flow_direction_at(monster_collision.position + monster_collision.scale / 2.0f) : no::vector2i{ 0 } };
+		if (is_chasing && (flow.x != 0 || flow.y != 0) && distance_to_player > tile_size_f) {
+			// Follow the room's flow field around walls, instead of walking straight at the player.
+			input_right = flow.x > 0;
+			input_left = flow.x < 0;
+			input_down = flow.y > 0;
+			input_up = flow.y < 0;
+		} else if (is_chasing) {
 			if (x_direction_change_timer.milliseconds() > 200) {
-				if (world->random.chance(0.05f) || distance_to_player > tile_size_f) {
+				if (room->random.chance(0.05f) || distance_to_player > tile_size_f) {
 					input_right = player_collision.position.x > monster_collision.position.x;
 					input_left = !input_right;
 					x_direction_change_timer.start();
 				}
 			}
 			if (y_direction_change_timer.milliseconds() > 200) {
-				if (world->random.chance(0.05f) || distance_to_player > tile_size_f) {
+				if (room->random.chance(0.05f) || distance_to_player > tile_size_f) {
 					input_down = player_collision.position.y > monster_collision.position.y;
 					input_up = !input_down;
 					y_direction_change_timer.start();
@@ -511,22 +522,31 @@ void monster_object::update() {
 			}
 		}
 	}
-	if (monster_type::is_melee(type) && distance_to_player < tile_size_f * 0.5f && become_angry_timer.seconds() > 2) {
+	const bool can_attack{ aware_of_player && become_angry_timer.seconds() > 2 };
+	if (monster_type::is_melee(type) && distance_to_player < tile_size_f * 0.5f && can_attack) {
 		attack();
-	} else if (monster_type::is_magic(type) && distance_to_player < tile_size_f * 3.0f && become_angry_timer.seconds() > 2) {
+	} else if (monster_type::is_magic(type) && distance_to_player < tile_size_f * 3.0f && can_attack) {
 		attack();
 	} else if (animation.is_looping() && type != monster_type::fire_boss && type != monster_type::water_boss && type != monster_type::final_boss) {
-		move(input_left, input_right, input_up, input_down); // POST-BUGFIX: Final boss should not move.
+		move(input_left, input_right, input_up, input_down, ticks); // POST-BUGFIX: Final boss should not move.
 	}
-	animation.update(1.0f / 60.0f);
+	animation.update(elapsed_seconds);
 	const auto combined_stats{ monster_type::get_stats(type) };
-	stats.health += combined_stats.health_regeneration_rate;
+	stats.health += combined_stats.health_regeneration_rate * static_cast<float>(ticks);
 	stats.health = std::min(stats.health, combined_stats.max_health);
-	stats.mana += combined_stats.mana_regeneration_rate;
+	stats.mana += combined_stats.mana_regeneration_rate * static_cast<float>(ticks);
 	stats.mana = std::min(stats.mana, combined_stats.max_mana);
 }
 
-void monster_object::move(bool left, bool right, bool up, bool down) {
+bool monster_object::can_be_reaped() const {
+	if (!dead || last_animation != animation_type::die || !animation.is_done()) {
+		return false;
+	}
+	// Dead bosses keep opening the reward dialog until the player leaves the dungeon.
+	return type != monster_type::fire_boss && type != monster_type::water_boss && type != monster_type::final_boss;
+}
+
+void monster_object::move(bool left, bool right, bool up, bool down, int ticks) {
 	is_moving = false;
 	direction_changed = false;
 	if (is_attacking()) {
@@ -541,11 +561,15 @@ void monster_object::move(bool left, bool right, bool up, bool down) {
 		facing_down = down;
 	}
 	direction_changed = (facing_right != old_facing_right || facing_down != old_facing_down);
-	const float speed{ 1.0f };
+	// Several ticks are covered by one longer step, so collision is only checked at its end.
+	const float speed{ static_cast<float>(ticks) };
 	const auto collision{ collision_transform() };
 	auto delta{ world->get_allowed_movement_delta(room, left, right, up, down, speed, collision.position, collision.scale) };
 	transform.position += delta;
 	is_moving = (delta.x != 0.0f || delta.y != 0.0f);
+	if (is_moving) {
+		room->update_collision_box(*this);
+	}
 }
 
 void monster_object::attack() {
@@ -569,7 +593,7 @@ void monster_object::attack() {
 	no::vector2f attack_speed{ facing_right ? 3.0f : -3.0f, facing_down ? 3.0f : -3.0f };
 	if (monster_type::is_melee(type) && monster_type::is_magic(type)) {
 		if (type == monster_type::fire_boss || type == monster_type::water_boss || type == monster_type::final_boss) {
-			if (world->random.chance(0.1f)) {
+			if (room->random.chance(0.1f)) {
 				room->spawn_attack(false, type, 1, attack_origin, attack_size, attack_speed, 100);
 				set_stab_animation();
 			} else {
@@ -583,7 +607,7 @@ void monster_object::attack() {
 				set_cast_animation();
 			}
 		} else {
-			if (world->random.chance(0.5f)) {
+			if (room->random.chance(0.5f)) {
 				room->spawn_attack(false, type, 1, attack_origin, attack_size, attack_speed, 100);
 				set_stab_animation();
 			} else {
@@ -26,6 +26,8 @@ bool is_magic(int type);
 no::vector2f sheet_frames(int type);
 object_stats get_stats(int type);
 no::transform2 get_collision_transform(int type);
+int animation_frames(int type, int animation);
+no::vector4f get_uv(int type, int animation, int direction);
 
 }
 
@@ -38,7 +40,8 @@ public:
 
 	monster_object(int type);
 
-	void update();
+	// Rooms far from the player are updated less often, with several ticks at once.
+	void update(int ticks = 1);
 	void attack();
 	void on_being_hit();
 
@@ -50,13 +53,16 @@ public:
 
 	void set_die_animation();
 
+	// True when the die animation has finished and nothing depends on the monster anymore.
+	bool can_be_reaped() const;
+
 	int class_type() const override {
 		return 2;
 	}
 
 private:
 
-	void monster_object::move(bool left, bool right, bool up, bool down);
+	void monster_object::move(bool left, bool right, bool up, bool down, int ticks);
 
 	void set_walk_animation();
 	void set_idle_animation();
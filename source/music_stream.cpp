@@ -0,0 +1,145 @@
+#include "music_stream.hpp"
+#include "audio_mixer.hpp"
+#include "async_log.hpp"
+
+#include <vorbis/vorbisfile.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+bool open_ogg(const std::string& path, OggVorbis_File& file, int& channels) {
+	if (ov_fopen(path.c_str(), &file) != 0) {
+		LOG_WARNING(log_category::audio, "Failed to open %s", path.c_str());
+		return false;
+	}
+	const vorbis_info* info{ ov_info(&file, -1) };
+	if (!info || info->rate != audio_sample_rate || info->channels < 1 || info->channels > 2) {
+		LOG_WARNING(log_category::audio, "%s must be mono or stereo at %i Hz", path.c_str(), audio_sample_rate);
+		ov_clear(&file);
+		return false;
+	}
+	channels = info->channels;
+	return true;
+}
+
+}
+
+music_stream::~music_stream() {
+	close();
+}
+
+bool music_stream::open(const std::string& new_path) {
+	close();
+	// Checked here so the caller knows, but the decoder opens its own handle.
+	OggVorbis_File file;
+	int channels{ 0 };
+	if (!open_ogg(new_path, file, channels)) {
+		return false;
+	}
+	ov_clear(&file);
+	path = new_path;
+	ring.assign(ring_frames * audio_channels, 0);
+	read_frame = 0;
+	write_frame = 0;
+	decoding = true;
+	decoder = std::thread{ [this] {
+		decode();
+	} };
+	return true;
+}
+
+void music_stream::close() {
+	if (!decoding) {
+		return;
+	}
+	decoding = false;
+	decoder_condition.notify_one();
+	decoder.join();
+}
+
+void music_stream::set_paused(bool new_paused) {
+	paused = new_paused;
+}
+
+bool music_stream::is_paused() const {
+	return paused;
+}
+
+void music_stream::mix_into(int* output, int frames) {
+	if (paused) {
+		return;
+	}
+	const long long read{ read_frame.load(std::memory_order_relaxed) };
+	const long long available{ write_frame.load(std::memory_order_acquire) - read };
+	const int count{ static_cast<int>(std::min<long long>(frames, available)) };
+	for (int i{ 0 }; i < count; i++) {
+		const int ring_index{ static_cast<int>((read + i) & (ring_frames - 1)) * audio_channels };
+		output[i * audio_channels] += ring[ring_index];
+		output[i * audio_channels + 1] += ring[ring_index + 1];
+	}
+	read_frame.store(read + count, std::memory_order_release);
+	if (count < frames && decoding) {
+		underrun_count++;
+	}
+	decoder_condition.notify_one();
+}
+
+void music_stream::wait_until_buffered(int frames) {
+	const auto give_up_time{ std::chrono::steady_clock::now() + std::chrono::seconds{ 1 } };
+	while (decoding && write_frame.load(std::memory_order_acquire) - read_frame.load(std::memory_order_relaxed) < frames) {
+		if (std::chrono::steady_clock::now() > give_up_time) {
+			LOG_WARNING(log_category::audio, "Gave up waiting for %s to decode", path.c_str());
+			return;
+		}
+		decoder_condition.notify_one();
+		std::this_thread::yield();
+	}
+}
+
+long long music_stream::underruns() const {
+	return underrun_count;
+}
+
+long long music_stream::loops() const {
+	return loop_count;
+}
+
+void music_stream::decode() {
+	OggVorbis_File file;
+	int channels{ 0 };
+	if (!open_ogg(path, file, channels)) {
+		return;
+	}
+	short chunk[chunk_frames * audio_channels];
+	int bitstream{ 0 };
+	while (decoding) {
+		const long long write{ write_frame.load(std::memory_order_relaxed) };
+		const long long free_frames{ ring_frames - (write - read_frame.load(std::memory_order_acquire)) };
+		if (free_frames < chunk_frames) {
+			// The mixer notifies after every read, and the timeout covers a notification sent before waiting.
+			std::unique_lock lock{ decoder_mutex };
+			decoder_condition.wait_for(lock, std::chrono::milliseconds{ 10 });
+			continue;
+		}
+		const long bytes{ ov_read(&file, reinterpret_cast<char*>(chunk), chunk_frames * channels * sizeof(short), 0, 2, 1, &bitstream) };
+		if (bytes == 0) {
+			// Continue from the first sample, so the end of the file is directly followed by its start.
+			ov_pcm_seek(&file, 0);
+			loop_count++;
+			continue;
+		}
+		if (bytes < 0) {
+			continue; // a hole in the data, decoding continues after it
+		}
+		const int frames{ static_cast<int>(bytes / (channels * sizeof(short))) };
+		for (int i{ 0 }; i < frames; i++) {
+			const int ring_index{ static_cast<int>((write + i) & (ring_frames - 1)) * audio_channels };
+			ring[ring_index] = chunk[i * channels];
+			ring[ring_index + 1] = chunk[i * channels + channels - 1];
+		}
+		write_frame.store(write + frames, std::memory_order_release);
+	}
+	ov_clear(&file);
+}
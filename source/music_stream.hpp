@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Decodes an OGG file in small chunks on its own thread into a ring buffer, which the mixer reads from.
+// Decoding continues from the start of the file as soon as it ends, so the loop has no gap.
+class music_stream {
+public:
+
+	static constexpr int ring_frames{ 16384 }; // about 370 ms, must be a power of two
+	static constexpr int chunk_frames{ 1024 };
+
+	music_stream() = default;
+	music_stream(const music_stream&) = delete;
+	music_stream(music_stream&&) = delete;
+	~music_stream();
+
+	music_stream& operator=(const music_stream&) = delete;
+	music_stream& operator=(music_stream&&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+
+	void set_paused(bool paused);
+	bool is_paused() const;
+
+	// When mixing faster than real time, the mixer would otherwise get ahead of the decoder and skip music.
+	// Gives up after a second, in case the decoder has stopped.
+	void wait_until_buffered(int frames);
+
+	// Adds up to the given number of interleaved stereo frames to the output. Called from the audio thread.
+	void mix_into(int* output, int frames);
+
+	long long underruns() const;
+	long long loops() const;
+
+private:
+
+	void decode();
+
+	std::string path;
+	std::vector<short> ring;
+	std::atomic<long long> read_frame{ 0 };
+	std::atomic<long long> write_frame{ 0 };
+	std::atomic<bool> paused{ false };
+	std::atomic<long long> underrun_count{ 0 };
+	std::atomic<long long> loop_count{ 0 };
+
+	std::thread decoder;
+	std::mutex decoder_mutex;
+	std::condition_variable decoder_condition;
+	std::atomic<bool> decoding{ false };
+
+};
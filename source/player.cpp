@@ -59,7 +59,7 @@ player_object::player_object() {
 void player_object::update() {
 	if (!room || !room->is_position_within(transform.position)) {
 		room = world->find_room(transform.position);
-		world->game->set_background(room->type);
+		world->events.push({ world_event_type::room_change, id, room->type, true, transform.position });
 	}
 	if (animation.is_done()) {
 		if (last_animation == animation_type::hit_flash) {
@@ -238,6 +238,19 @@ void player_object::set_die_animation() {
 }
 //
 
+no::vector4f player_object::animation_strip() const {
+	const int direction_index{ facing_down ? 1 : 0 };
+	switch (last_animation) {
+	case animation_type::walk: return player_uv_walk[direction_index];
+	case animation_type::stab: return player_uv_stab[direction_index];
+	case animation_type::cast: return player_uv_cast[direction_index];
+	case animation_type::hit: return player_uv_hit[direction_index];
+	case animation_type::die: return player_uv_die[direction_index];
+	case animation_type::hit_flash: return player_uv_hit_flash[direction_index];
+	default: return player_uv_idle[direction_index];
+	}
+}
+
 no::transform2 player_object::collision_transform() const {
 	no::transform2 collision;
 	collision.position = transform.position + collision::offset;
@@ -298,6 +311,22 @@ int player_object::item_in_slot(int slot) const {
 	return items[slot];
 }
 
+player_object::inventory player_object::save_inventory() const {
+	inventory result;
+	result.weapons = weapons;
+	result.weapon = weapon;
+	std::copy(std::begin(items), std::end(items), std::begin(result.items));
+	result.power = power;
+	return result;
+}
+
+void player_object::load_inventory(const inventory& inventory) {
+	weapons = inventory.weapons;
+	weapon = inventory.weapon;
+	std::copy(std::begin(inventory.items), std::end(inventory.items), std::begin(items));
+	power = inventory.power;
+}
+
 object_stats player_object::final_stats() const {
 	auto result{ stats };
 	for (const int item : items) {
@@ -336,6 +365,7 @@ void player_object::open_chest() {
 	for (auto& chest : room->chests) {
 		if (!chest.open && chest.collision_transform().distance_to(collision_transform()) < 20.0f) {
 			chest.open = true;
+			room->update_collision_box(chest);
 			if (chest.is_crate) {
 				if (world->random.chance(0.15f)) {
 					if (item_type::is_weapon(chest.item)) {
@@ -348,7 +378,7 @@ void player_object::open_chest() {
 						}
 					}
 				}
-			} else {
+			} else if (world->game) {
 				world->game->ui.on_chest_open(chest.item);
 			}
 		}
@@ -9,6 +9,13 @@ public:
 
 	bool locked_by_ui{ false };
 
+	struct inventory {
+		std::vector<int> weapons; // item_type
+		int weapon{ -1 }; // weapons index
+		int items[8]{}; // item_type
+		int power{ -1 }; // item_type
+	};
+
 	struct collision {
 		static constexpr no::vector2f offset{ 10.0f, 16.0f };
 		static constexpr no::vector2f size{ 11.0f, 13.0f };
@@ -28,6 +35,8 @@ public:
 	void give_item(int type, int slot);
 	int active_power() const;
 	int item_in_slot(int slot) const;
+	inventory save_inventory() const;
+	void load_inventory(const inventory& inventory);
 	bool has_empty_slot() const {
 		for (int i{ 2 }; i < 8; i++) {
 			if (items[i] < 0) {
@@ -46,6 +55,9 @@ public:
 	void open_chest();
 
 	void set_die_animation();
+
+	// The texture coordinates given to the animation for its current strip.
+	no::vector4f animation_strip() const;
 private:
 
 	std::vector<int> weapons; // item_type
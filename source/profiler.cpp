@@ -0,0 +1,140 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+constexpr int events_per_thread{ 1 << 16 };
+
+struct profile_event {
+	const char* name{ nullptr };
+	long long start_ns{ 0 };
+	long long end_ns{ 0 };
+};
+
+// Only the owning thread writes to a buffer, including when it's cleared. Once full, the oldest events are overwritten.
+struct thread_buffer {
+	int thread_id{ 0 };
+	std::atomic<long long> written{ 0 };
+	std::atomic<int> generation{ 0 }; // the clear generation the events belong to
+	profile_event events[events_per_thread];
+};
+
+const auto epoch{ std::chrono::steady_clock::now() };
+std::atomic<bool> recording{ false };
+std::atomic<int> clear_generation{ 0 };
+std::mutex buffers_mutex;
+std::vector<std::unique_ptr<thread_buffer>> buffers;
+
+thread_buffer& get_thread_buffer() {
+	thread_local thread_buffer* buffer{ nullptr };
+	if (!buffer) {
+		std::lock_guard lock{ buffers_mutex };
+		auto& new_buffer{ buffers.emplace_back(std::make_unique<thread_buffer>()) };
+		new_buffer->thread_id = static_cast<int>(buffers.size());
+		new_buffer->generation = clear_generation.load(std::memory_order_acquire);
+		buffer = new_buffer.get();
+	}
+	return *buffer;
+}
+
+void write_escaped(std::ofstream& file, const char* text) {
+	for (; *text; text++) {
+		if (*text == '"' || *text == '\\') {
+			file << '\\';
+		}
+		file << *text;
+	}
+}
+
+// A buffer that hasn't recorded since the last clear still holds events from before it.
+long long written_since_clear(const thread_buffer& buffer) {
+	if (buffer.generation.load(std::memory_order_acquire) != clear_generation.load(std::memory_order_acquire)) {
+		return 0;
+	}
+	return buffer.written.load(std::memory_order_acquire);
+}
+
+}
+
+namespace profiler {
+
+void set_recording(bool new_recording) {
+	recording = new_recording;
+}
+
+bool is_recording() {
+	return recording.load(std::memory_order_relaxed);
+}
+
+int recorded_zones() {
+	std::lock_guard lock{ buffers_mutex };
+	long long zones{ 0 };
+	for (const auto& buffer : buffers) {
+		zones += std::min(written_since_clear(*buffer), static_cast<long long>(events_per_thread));
+	}
+	return static_cast<int>(zones);
+}
+
+void clear() {
+	// Each thread resets its own buffer the next time it records.
+	clear_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+bool export_chrome_trace(const std::string& path) {
+	std::ofstream file{ path };
+	if (!file.is_open()) {
+		return false;
+	}
+	std::lock_guard lock{ buffers_mutex };
+	file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+	bool first{ true };
+	std::vector<profile_event> events;
+	for (const auto& buffer : buffers) {
+		const long long written{ written_since_clear(*buffer) };
+		const long long first_event{ std::max(0LL, written - events_per_thread) };
+		events.assign(buffer->events + first_event % events_per_thread, buffer->events + events_per_thread);
+		events.insert(events.end(), buffer->events, buffer->events + first_event % events_per_thread);
+		events.resize(written - first_event);
+		// The owning thread may have overwritten the oldest events while they were copied, so skip those.
+		const long long written_after{ buffer->written.load(std::memory_order_acquire) };
+		const long long valid_event{ std::max(first_event, written_after - events_per_thread) };
+		for (long long i{ valid_event }; i < written; i++) {
+			const auto& event{ events[i - first_event] };
+			file << (first ? "\n" : ",\n") << "{\"name\":\"";
+			write_escaped(file, event.name);
+			// Timestamps are in microseconds, but fractions are allowed.
+			file << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->thread_id
+				<< ",\"ts\":" << static_cast<double>(event.start_ns) / 1000.0
+				<< ",\"dur\":" << static_cast<double>(event.end_ns - event.start_ns) / 1000.0 << "}";
+			first = false;
+		}
+	}
+	file << "\n]}\n";
+	return true;
+}
+
+long long now_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void record(const char* name, long long start_ns, long long end_ns) {
+	auto& buffer{ get_thread_buffer() };
+	const int generation{ clear_generation.load(std::memory_order_acquire) };
+	if (buffer.generation.load(std::memory_order_relaxed) != generation) {
+		buffer.written.store(0, std::memory_order_release);
+		buffer.generation.store(generation, std::memory_order_release);
+	}
+	const long long index{ buffer.written.load(std::memory_order_relaxed) };
+	buffer.events[index % events_per_thread] = { name, start_ns, end_ns };
+	buffer.written.store(index + 1, std::memory_order_release);
+}
+
+}
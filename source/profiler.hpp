@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+
+// Scoped timing zones, recorded per thread and exported as Chrome trace events (chrome://tracing).
+#define WITH_PROFILER 1
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if WITH_PROFILER
+// The name must outlive the profiler, so use string literals.
+#define PROFILE_ZONE(name) profile_zone PROFILE_CONCAT(profile_zone_, __LINE__){ name }
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+namespace profiler {
+
+void set_recording(bool recording);
+bool is_recording();
+
+// Zones recorded since the last clear, summed over all threads. Capped at the ring buffer size per thread.
+int recorded_zones();
+void clear();
+
+// Writes the buffered zones of all threads as a Chrome trace-event JSON file. Best done while not recording.
+bool export_chrome_trace(const std::string& path);
+
+long long now_ns();
+void record(const char* name, long long start_ns, long long end_ns);
+
+}
+
+class profile_zone {
+public:
+
+	profile_zone(const char* name) : name{ name }, start_ns{ profiler::is_recording() ? profiler::now_ns() : -1 } {
+
+	}
+
+	profile_zone(const profile_zone&) = delete;
+	profile_zone(profile_zone&&) = delete;
+
+	~profile_zone() {
+		if (start_ns >= 0) {
+			profiler::record(name, start_ns, profiler::now_ns());
+		}
+	}
+
+	profile_zone& operator=(const profile_zone&) = delete;
+	profile_zone& operator=(profile_zone&&) = delete;
+
+private:
+
+	const char* name{ nullptr };
+	long long start_ns{ -1 };
+
+};
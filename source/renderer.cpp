@@ -4,87 +4,105 @@
 #include "assets.hpp"
 #include "window.hpp"
 #include "surface.hpp"
+#include "profiler.hpp"
 
 namespace uv {
 constexpr no::vector4f chest_closed{ 0.0f, 0.0f, 0.25f, 1.0f };
 constexpr no::vector4f chest_open{ 0.25f, 0.0f, 0.25f, 1.0f };
 constexpr no::vector4f crate{ 0.5f, 0.0f, 0.25f, 1.0f };
 constexpr no::vector4f broken_crate{ 0.75f, 0.0f, 0.25f, 1.0f };
+constexpr no::vector4f magic{ 0.0f, 0.0f, 1.0f / 7.0f, 1.0f / 3.0f };
+constexpr no::vector4f whole{ 0.0f, 0.0f, 1.0f, 1.0f };
 }
 
-game_renderer::game_renderer(game_state& game) : game{ game } {
-	shader = no::require_shader("sprite");
-	blank_texture = no::create_texture({ 2, 2, no::pixel_format::rgba, 0xFFFFFFFF });
+std::optional<no::vector3f> room_background_color(char room_type) {
+	switch (room_type) {
+	case 'f': return no::vector3f{ 71.0f / 256.0f, 27.0f / 256.0f, 0.0f };
+	case 'w': return no::vector3f{ 0.0f, 36.0f / 256.0f, 71.0f / 256.0f };
+	case 'l': return no::vector3f{ 27.0f / 256.0f, 42.0f / 256.0f, 39.0f / 256.0f };
+	default: return {};
+	}
+}
+
+game_renderer::game_renderer(game_state& game) : game_renderer{ game.world } {
+	this->game = &game;
+}
+
+game_renderer::game_renderer(game_world& world) : world{ world } {
+	shader = draw_target::require_shader("sprite");
+	blank_texture = draw_target::create_texture({ 2, 2, no::pixel_format::rgba, 0xFFFFFFFF });
 	room_transform.scale = static_cast<float>(tile_size);
-	fire_tiles_texture = no::require_texture("fire_tiles");
-	water_tiles_texture = no::require_texture("water_tiles");
-	light_tiles_texture = no::require_texture("light_tiles");
-	player_texture = no::require_texture("player");
-	normal_weapon_texture = no::require_texture("normal");
-	fire_weapon_texture = no::require_texture("fire");
-	water_weapon_texture = no::require_texture("water");
-	chest_texture = no::require_texture("chest");
-	magic_texture = no::require_texture("magic");
-	monster_texture[monster_type::skeleton] = no::require_texture("skeleton");
-	monster_texture[monster_type::life_wizard] = no::require_texture("life_wizard");
-	monster_texture[monster_type::dark_wizard] = no::require_texture("dark_wizard");
-	monster_texture[monster_type::toxic_wizard] = no::require_texture("toxic_wizard");
-	monster_texture[monster_type::big_fire_slime] = no::require_texture("big_fire_slime");
-	monster_texture[monster_type::small_fire_slime] = no::require_texture("small_fire_slime");
-	monster_texture[monster_type::big_water_slime] = no::require_texture("big_water_slime");
-	monster_texture[monster_type::small_water_slime] = no::require_texture("small_water_slime");
-	monster_texture[monster_type::knight] = no::require_texture("knight");
-	monster_texture[monster_type::water_fish] = no::require_texture("water_fish");
-	monster_texture[monster_type::fire_imp] = no::require_texture("fire_imp");
-	monster_texture[monster_type::fire_boss] = no::require_texture("fire_boss");
-	monster_texture[monster_type::water_boss] = no::require_texture("water_boss");
-	monster_texture[monster_type::final_boss] = no::require_texture("final_boss");
-	//slash_texture = no::require_texture("slash");
-	open_chest_rectangle.set_tex_coords(uv::chest_open.x, uv::chest_open.y, uv::chest_open.z, uv::chest_open.w);
-	closed_chest_rectangle.set_tex_coords(uv::chest_closed.x, uv::chest_closed.y, uv::chest_closed.z, uv::chest_closed.w);
-	crate_rectangle.set_tex_coords(uv::crate.x, uv::crate.y, uv::crate.z, uv::crate.w);
-	broken_crate_rectangle.set_tex_coords(uv::broken_crate.x, uv::broken_crate.y, uv::broken_crate.z, uv::broken_crate.w);
+	fire_tiles_texture = draw_target::require_texture("fire_tiles");
+	water_tiles_texture = draw_target::require_texture("water_tiles");
+	light_tiles_texture = draw_target::require_texture("light_tiles");
+	player_texture = draw_target::require_texture("player");
+	normal_weapon_texture = draw_target::require_texture("normal");
+	fire_weapon_texture = draw_target::require_texture("fire");
+	water_weapon_texture = draw_target::require_texture("water");
+	chest_texture = draw_target::require_texture("chest");
+	magic_texture = draw_target::require_texture("magic");
+	monster_texture[monster_type::skeleton] = draw_target::require_texture("skeleton");
+	monster_texture[monster_type::life_wizard] = draw_target::require_texture("life_wizard");
+	monster_texture[monster_type::dark_wizard] = draw_target::require_texture("dark_wizard");
+	monster_texture[monster_type::toxic_wizard] = draw_target::require_texture("toxic_wizard");
+	monster_texture[monster_type::big_fire_slime] = draw_target::require_texture("big_fire_slime");
+	monster_texture[monster_type::small_fire_slime] = draw_target::require_texture("small_fire_slime");
+	monster_texture[monster_type::big_water_slime] = draw_target::require_texture("big_water_slime");
+	monster_texture[monster_type::small_water_slime] = draw_target::require_texture("small_water_slime");
+	monster_texture[monster_type::knight] = draw_target::require_texture("knight");
+	monster_texture[monster_type::water_fish] = draw_target::require_texture("water_fish");
+	monster_texture[monster_type::fire_imp] = draw_target::require_texture("fire_imp");
+	monster_texture[monster_type::fire_boss] = draw_target::require_texture("fire_boss");
+	monster_texture[monster_type::water_boss] = draw_target::require_texture("water_boss");
+	monster_texture[monster_type::final_boss] = draw_target::require_texture("final_boss");
+	//slash_texture = draw_target::require_texture("slash");
+	open_chest_rectangle.set_tex_coords(uv::chest_open);
+	closed_chest_rectangle.set_tex_coords(uv::chest_closed);
+	crate_rectangle.set_tex_coords(uv::crate);
+	broken_crate_rectangle.set_tex_coords(uv::broken_crate);
 	//slash_animation.frames = 6;
 	//slash_animation.stop_looping();
 
 }
 
 game_renderer::~game_renderer() {
-	no::delete_texture(blank_texture);
-	no::release_texture("fire_tiles");
-	no::release_texture("water_tiles");
-	no::release_texture("light_tiles");
-	no::release_texture("chest");
-	no::release_texture("magic");
-	no::release_texture("player");
-	no::release_texture("normal");
-	no::release_texture("fire");
-	no::release_texture("water");
-	no::release_shader("sprite");
-	no::release_texture("skeleton");
-	no::release_texture("life_wizard");
-	no::release_texture("dark_wizard");
-	no::release_texture("toxic_wizard");
-	no::release_texture("big_fire_slime");
-	no::release_texture("small_fire_slime");
-	no::release_texture("big_water_slime");
-	no::release_texture("small_water_slime");
-	no::release_texture("knight");
-	no::release_texture("water_fish");
-	no::release_texture("fire_imp");
-	no::release_texture("fire_boss");
-	no::release_texture("water_boss");
-	no::release_texture("final_boss");
-	//no::release_texture("slash");
+	draw_target::delete_texture(blank_texture);
+	draw_target::release_texture("fire_tiles");
+	draw_target::release_texture("water_tiles");
+	draw_target::release_texture("light_tiles");
+	draw_target::release_texture("chest");
+	draw_target::release_texture("magic");
+	draw_target::release_texture("player");
+	draw_target::release_texture("normal");
+	draw_target::release_texture("fire");
+	draw_target::release_texture("water");
+	draw_target::release_shader("sprite");
+	draw_target::release_texture("skeleton");
+	draw_target::release_texture("life_wizard");
+	draw_target::release_texture("dark_wizard");
+	draw_target::release_texture("toxic_wizard");
+	draw_target::release_texture("big_fire_slime");
+	draw_target::release_texture("small_fire_slime");
+	draw_target::release_texture("big_water_slime");
+	draw_target::release_texture("small_water_slime");
+	draw_target::release_texture("knight");
+	draw_target::release_texture("water_fish");
+	draw_target::release_texture("fire_imp");
+	draw_target::release_texture("fire_boss");
+	draw_target::release_texture("water_boss");
+	draw_target::release_texture("final_boss");
+	//draw_target::release_texture("slash");
 }
 
 void game_renderer::update() {
-	camera.zoom = game.zoom;
-	camera.transform.scale = game.window().size().to<float>();
-	if (game.god_mode) {
+	if (game) {
+		camera.zoom = game->zoom;
+		camera.transform.scale = game->window().size().to<float>();
+	}
+	if (game && game->god_mode) {
 		camera.target = nullptr;
 	} else {
-		camera.target = &game.world.player.transform;
+		camera.target = &world.player.transform;
 		camera.target_chase_speed = 0.075f;
 		camera.target_chase_aspect = { 2.0f, 2.0f };
 	}
@@ -93,23 +111,28 @@ void game_renderer::update() {
 }
 
 void game_renderer::draw() {
+	PROFILE_ZONE("game_renderer::draw");
 	render();
-	no::bind_shader(shader);
-	no::set_shader_view_projection(camera);
-	draw_world(game.world);
+	statistics = {};
+	view_min = camera.transform.position - tile_size_f;
+	view_max = camera.transform.position + camera.size() + tile_size_f;
+	draw_target::bind_shader(shader);
+	draw_target::set_view_projection(camera);
+	draw_world(world);
 }
 
 void game_renderer::render() {
-	for (const auto& room : game.world.rooms) {
+	for (const auto& room : world.rooms) {
 		render_room(room);
 	}
 }
 
 void game_renderer::render_room(const game_world_room& room) {
+	PROFILE_ZONE("game_renderer::render_room");
 	if (is_rendered(room)) {
 		return;
 	}
-	no::vector2f tileset_size{ no::texture_size(fire_tiles_texture).to<float>() };
+	no::vector2f tileset_size{ draw_target::texture_size(fire_tiles_texture).to<float>() };
 	no::vector2f uv_step{ 32.0f / tileset_size };
 	auto& rendered_room{ rendered_rooms.emplace_back() };
 	rendered_room.room = &room;
@@ -117,23 +140,31 @@ void game_renderer::render_room(const game_world_room& room) {
 	no::sprite_vertex top_right;
 	no::sprite_vertex bottom_right;
 	no::sprite_vertex bottom_left;
-	for (int x{ room.left() }; x < room.right(); x++) {
-		for (int y{ room.top() }; y < room.bottom(); y++) {
-			const int local_x{ x - room.index.x };
-			const int local_y{ y - room.index.y };
-			const auto& tile{ room.tile_at(local_x, local_y) };
-			const auto auto_uv{ game.world.autotiler.get_uv(tile) };
-			const no::vector2f uv_1{ auto_uv.to<float>() / tileset_size };
-			const no::vector2f uv_2{ uv_1 + uv_step };
-			top_left.position = { static_cast<float>(x), static_cast<float>(y) };
-			top_right.position = { static_cast<float>(x + 1), static_cast<float>(y) };
-			bottom_right.position = { static_cast<float>(x + 1), static_cast<float>(y + 1) };
-			bottom_left.position = { static_cast<float>(x), static_cast<float>(y + 1) };
-			top_left.tex_coords = uv_1;
-			top_right.tex_coords = { uv_2.x, uv_1.y };
-			bottom_left.tex_coords = { uv_1.x, uv_2.y };
-			bottom_right.tex_coords = uv_2;
-			rendered_room.shape.append(top_left, top_right, bottom_right, bottom_left);
+	for (int chunk_x{ room.left() }; chunk_x < room.right(); chunk_x += render_chunk_size) {
+		for (int chunk_y{ room.top() }; chunk_y < room.bottom(); chunk_y += render_chunk_size) {
+			auto& chunk{ rendered_room.chunks.emplace_back() };
+			chunk.min = { chunk_x, chunk_y };
+			chunk.max = { std::min(chunk_x + render_chunk_size, room.right()), std::min(chunk_y + render_chunk_size, room.bottom()) };
+			for (int x{ chunk.min.x }; x < chunk.max.x; x++) {
+				for (int y{ chunk.min.y }; y < chunk.max.y; y++) {
+					const int local_x{ x - room.index.x };
+					const int local_y{ y - room.index.y };
+					const auto& tile{ room.tile_at(local_x, local_y) };
+					const auto auto_uv{ world.autotiler.get_uv(tile) };
+					const no::vector2f uv_1{ auto_uv.to<float>() / tileset_size };
+					const no::vector2f uv_2{ uv_1 + uv_step };
+					top_left.position = { static_cast<float>(x), static_cast<float>(y) };
+					top_right.position = { static_cast<float>(x + 1), static_cast<float>(y) };
+					bottom_right.position = { static_cast<float>(x + 1), static_cast<float>(y + 1) };
+					bottom_left.position = { static_cast<float>(x), static_cast<float>(y + 1) };
+					top_left.tex_coords = uv_1;
+					top_right.tex_coords = { uv_2.x, uv_1.y };
+					bottom_left.tex_coords = { uv_1.x, uv_2.y };
+					bottom_right.tex_coords = uv_2;
+					chunk.shape.append(top_left, top_right, bottom_right, bottom_left);
+				}
+			}
+			chunk.shape.refresh();
 		}
 	}
 	for (const auto door : room.doors) {
@@ -180,7 +211,6 @@ void game_renderer::render_room(const game_world_room& room) {
 			rendered_room.doors.append(top_left, top_right, bottom_right, bottom_left);
 		}
 	}
-	rendered_room.shape.refresh();
 	if (!room.doors.empty()) {
 		rendered_room.doors.refresh();
 	}
@@ -205,27 +235,39 @@ bool game_renderer::is_rendered(const game_world_room& room) const {
 }
 
 void game_renderer::draw_world(const game_world& world) {
-	no::get_shader_variable("color").set(no::vector4f{ 1.0f });
-	no::set_shader_model(room_transform);
+	draw_target::set_color(1.0f);
+	draw_target::set_model(room_transform);
 	for (const auto& room : rendered_rooms) {
-		if (room.room == world.player.room || game.show_all_rooms) {
-			if (room.room->type == 'f') {
-				no::bind_texture(fire_tiles_texture);
-			} else if (room.room->type == 'w') {
-				no::bind_texture(water_tiles_texture);
-			} else if (room.room->type == 'l') {
-				no::bind_texture(light_tiles_texture);
+		if (room.room != world.player.room && !is_showing_all_rooms()) {
+			continue;
+		}
+		const no::vector2f room_position{ room.room->index.to<float>() * tile_size_f };
+		const no::vector2f room_size{ static_cast<float>(room.room->width() * tile_size), static_cast<float>(room.room->height() * tile_size) };
+		if (!is_visible(room_position, room_size)) {
+			statistics.chunks_culled += static_cast<int>(room.chunks.size());
+			continue;
+		}
+		if (room.room->type == 'f') {
+			draw_target::bind_texture(fire_tiles_texture);
+		} else if (room.room->type == 'w') {
+			draw_target::bind_texture(water_tiles_texture);
+		} else if (room.room->type == 'l') {
+			draw_target::bind_texture(light_tiles_texture);
+		}
+		for (const auto& chunk : room.chunks) {
+			if (!is_visible(chunk.min.to<float>() * tile_size_f, (chunk.max - chunk.min).to<float>() * tile_size_f)) {
+				statistics.chunks_culled++;
+				continue;
 			}
-			room.shape.bind();
-			room.shape.draw();
-			room.doors.bind();
-			room.doors.draw();
+			chunk.shape.draw();
+			statistics.chunks_drawn++;
 		}
+		room.doors.draw();
 	}
 	draw_objects(world);
 
 	for (const auto& room : rendered_rooms) {
-		if (room.room == world.player.room || game.show_all_rooms) {
+		if (room.room == world.player.room || is_showing_all_rooms()) {
 			for (const auto& attack : room.room->attacks) {
 				int projectile{ -1 };
 				if (attack.by_player) {
@@ -242,45 +284,61 @@ void game_renderer::draw_world(const game_world& world) {
 				no::transform2 transform;
 				transform.position = attack.position;
 				transform.scale = 16.0f;
-				no::bind_texture(magic_texture);
-				rectangle.set_tex_coords(0.0f, 0.0f, 1.0f / 7.0f, 1.0f / 3.0f);
-				no::draw_shape(rectangle, transform);
+				if (!is_visible(transform.position, transform.scale)) {
+					statistics.attacks_culled++;
+					continue;
+				}
+				statistics.attacks_drawn++;
+				draw_target::bind_texture(magic_texture);
+				rectangle.set_tex_coords(uv::magic);
+				rectangle.draw(transform);
 			}
 		}
 	}
 
-	if (game.show_collisions && world.player.room) {
-		no::bind_texture(blank_texture);
-		no::get_shader_variable("color").set(no::vector4f{ 1.0f, 0.0f, 0.0f, 1.0f });
+	if (game && game->show_collisions && world.player.room) {
+		draw_target::bind_texture(blank_texture);
+		draw_target::set_color({ 1.0f, 0.0f, 0.0f, 1.0f });
+		rectangle.set_tex_coords(uv::whole);
 		for (auto& attack : world.player.room->attacks) {
-			no::draw_shape(rectangle, no::transform2{ attack.position, attack.size });
+			rectangle.draw(no::transform2{ attack.position, attack.size });
 		}
 		for (auto& monster : world.player.room->monsters) {
-			no::draw_shape(rectangle, monster.collision_transform());
+			rectangle.draw(monster.collision_transform());
 		}
 		for (auto& chest : world.player.room->chests) {
-			no::draw_shape(rectangle, chest.collision_transform());
+			rectangle.draw(chest.collision_transform());
 		}
-		no::draw_shape(rectangle, world.player.collision_transform());
-		no::get_shader_variable("color").set(no::vector4f{ 1.0f });
+		rectangle.draw(world.player.collision_transform());
+		draw_target::set_color(1.0f);
 	}
 }
 
 void game_renderer::draw_objects(const game_world& world) {
 	// didn't think it would come to doing it like this... but o'well. time is running out. need it to sort.
-	std::vector<const game_object*> objects;
-	objects.reserve(50);
+	auto& objects{ sorted_objects };
+	objects.clear();
 	for (const auto& room : rendered_rooms) {
-		if (room.room == world.player.room || game.show_all_rooms) {
+		if (room.room == world.player.room || is_showing_all_rooms()) {
 			for (const auto& monster : room.room->monsters) {
-				objects.push_back(&monster);
+				const no::vector2f size{ draw_target::texture_size(monster_texture[monster.type]).to<float>() / monster_type::sheet_frames(monster.type) };
+				if (is_visible(monster.transform.position, size)) {
+					objects.push_back(&monster);
+				} else {
+					statistics.objects_culled++;
+				}
 			}
 			for (const auto& chest : room.room->chests) {
-				objects.push_back(&chest);
+				if (is_visible(chest.transform.position, 32.0f)) {
+					objects.push_back(&chest);
+				} else {
+					statistics.objects_culled++;
+				}
 			}
 		}
 	}
 	objects.push_back(&world.player);
+	statistics.objects_drawn = static_cast<int>(objects.size());
 	std::sort(objects.begin(), objects.end(), [&](const game_object* a, const game_object* b) {
 		return b->transform.position.y > a->transform.position.y;
 	});
@@ -300,53 +358,63 @@ void game_renderer::draw_objects(const game_world& world) {
 }
 
 void game_renderer::draw_monster(const monster_object& monster) {
-	no::bind_texture(monster_texture[monster.type]);
-	no::vector2f size{ no::texture_size(monster_texture[monster.type]).to<float>() / monster_type::sheet_frames(monster.type) };
+	draw_target::bind_texture(monster_texture[monster.type]);
+	no::vector2f size{ draw_target::texture_size(monster_texture[monster.type]).to<float>() / monster_type::sheet_frames(monster.type) };
 	no::vector2f position{ monster.transform.position };
 	if (!monster.facing_right) {
 		position.x += size.x;
 		size.x = -size.x;
 	}
-	monster.animation.draw(position, size);
+	const auto strip{ monster_type::get_uv(monster.type, std::max(monster.last_animation, 0), monster.facing_down ? 1 : 0) };
+	draw_target::draw_animation(monster.animation, position, size, strip);
 }
 
 void game_renderer::draw_chest(const chest_object& chest) {
 	no::transform2 chest_transform;
 	chest_transform.position = chest.transform.position;
 	chest_transform.scale = 32.0f;
-	no::bind_texture(chest_texture);
+	draw_target::bind_texture(chest_texture);
 	if (chest.is_crate) { // yep. it's ld after all.
-		no::draw_shape(chest.open ? broken_crate_rectangle : crate_rectangle, chest_transform);
+		(chest.open ? broken_crate_rectangle : crate_rectangle).draw(chest_transform);
 	} else {
-		no::draw_shape(chest.open ? open_chest_rectangle : closed_chest_rectangle, chest_transform);
+		(chest.open ? open_chest_rectangle : closed_chest_rectangle).draw(chest_transform);
 	}
 }
 
 void game_renderer::draw_player(const player_object& player) {
-	no::vector2f size{ no::texture_size(player_texture).to<float>() / no::vector2f{ 4.0f, player_animation_rows } };
+	no::vector2f size{ draw_target::texture_size(player_texture).to<float>() / no::vector2f{ 4.0f, player_animation_rows } };
 	no::vector2f position{ player.transform.position };
 	if (!player.facing_right) {
 		position.x += size.x;
 		size.x = -size.x;
 	}
-	no::bind_texture(player_texture);
-	player.animation.draw(position, size);
+	const auto strip{ player.animation_strip() };
+	draw_target::bind_texture(player_texture);
+	draw_target::draw_animation(player.animation, position, size, strip);
 	if (item_type::is_weapon(player.equipped_weapon())) {
 		switch (player.active_power()) {
 		case item_type::fire_head:
-			no::bind_texture(fire_weapon_texture);
+			draw_target::bind_texture(fire_weapon_texture);
 			break;
 		case item_type::water_head:
-			no::bind_texture(water_weapon_texture);
+			draw_target::bind_texture(water_weapon_texture);
 			break;
 		default:
-			no::bind_texture(normal_weapon_texture);
+			draw_target::bind_texture(normal_weapon_texture);
 			break;
 		}
-		player.animation.draw(position, size);
+		draw_target::draw_animation(player.animation, position, size, strip);
 	}
 }
 
 void game_renderer::clear_rendered() {
 	rendered_rooms.clear();
 }
+
+bool game_renderer::is_showing_all_rooms() const {
+	return game && game->show_all_rooms;
+}
+
+bool game_renderer::is_visible(no::vector2f position, no::vector2f size) const {
+	return position.x < view_max.x && position.y < view_max.y && position.x + size.x > view_min.x && position.y + size.y > view_min.y;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "draw.hpp"
+#include "draw_target.hpp"
 #include "camera.hpp"
 #include "monster.hpp"
 
@@ -10,14 +11,32 @@ class game_world_room;
 class player_object;
 class chest_object;
 
+// The clear color behind rooms of the type, for the types that have one.
+std::optional<no::vector3f> room_background_color(char room_type);
+
+// Tiles are uploaded in square chunks so that rooms only partly on screen can be culled.
+constexpr int render_chunk_size{ 8 };
+
+struct render_statistics {
+	int chunks_drawn{ 0 };
+	int chunks_culled{ 0 };
+	int objects_drawn{ 0 };
+	int objects_culled{ 0 };
+	int attacks_drawn{ 0 };
+	int attacks_culled{ 0 };
+};
+
 class game_renderer {
 public:
 
 	int blank_texture{ -1 };
 
 	no::ortho_camera camera;
+	render_statistics statistics;
 
 	game_renderer(game_state& game);
+	// Without a game, the camera's size and zoom are left to the caller, and only the player's room is shown.
+	game_renderer(game_world& world);
 	~game_renderer();
 
 	void update();
@@ -35,12 +54,17 @@ public:
 
 	void clear_rendered();
 
+	bool is_visible(no::vector2f position, no::vector2f size) const;
+
 	int shader{ -1 };
-	no::rectangle rectangle;
+	textured_rectangle rectangle;
 
 private:
 
-	game_state& game;
+	bool is_showing_all_rooms() const;
+
+	game_state* game{ nullptr };
+	game_world& world;
 	int fire_tiles_texture{ -1 };
 	int water_tiles_texture{ -1 };
 	int light_tiles_texture{ -1 };
@@ -56,17 +80,28 @@ private:
 
 	no::transform2 room_transform;
 
-	no::rectangle open_chest_rectangle;
-	no::rectangle closed_chest_rectangle;
-	no::rectangle crate_rectangle;
-	no::rectangle broken_crate_rectangle;
+	textured_rectangle open_chest_rectangle;
+	textured_rectangle closed_chest_rectangle;
+	textured_rectangle crate_rectangle;
+	textured_rectangle broken_crate_rectangle;
+
+	struct rendered_chunk {
+		quad_list shape;
+		no::vector2i min; // in tiles
+		no::vector2i max;
+	};
 
 	struct rendered_room {
-		no::quad_array<no::sprite_vertex, unsigned short> shape;
-		no::quad_array<no::sprite_vertex, unsigned short> doors;
+		std::vector<rendered_chunk> chunks;
+		quad_list doors;
 		const game_world_room* room{ nullptr };
 	};
 
 	std::vector<rendered_room> rendered_rooms;
+	std::vector<const game_object*> sorted_objects;
+
+	// Visible area of the world in pixels, updated before each draw.
+	no::vector2f view_min;
+	no::vector2f view_max;
 
 };
@@ -0,0 +1,150 @@
+#include "software_frame.hpp"
+#include "draw_target.hpp"
+#include "renderer.hpp"
+#include "world.hpp"
+#include "item.hpp"
+#include "async_log.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <optional>
+
+namespace {
+
+// The size of the game's window.
+constexpr no::vector2i headless_frame_size{ 800, 600 };
+constexpr float headless_zoom{ 2.0f };
+constexpr int golden_tolerance{ 2 };
+
+// Enough floor for the objects, with a pillar for the wall tiles inside the room.
+constexpr no::vector2i scene_room_size{ 14, 11 };
+
+struct scene_monster {
+	int type{ 0 };
+	no::vector2i tile;
+	bool facing_right{ false };
+};
+
+constexpr scene_monster scene_monsters[]{
+	{ monster_type::skeleton, { 3, 2 }, true },
+	{ monster_type::knight, { 10, 2 }, false },
+	{ monster_type::dark_wizard, { 2, 7 }, true },
+	{ monster_type::big_fire_slime, { 9, 7 }, false },
+	{ monster_type::fire_imp, { 11, 5 }, false }
+};
+
+uint32_t to_pixel(no::vector3f color) {
+	const auto to_channel{ [](float value) {
+		return static_cast<uint32_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f);
+	} };
+	return 0xFF000000 | (to_channel(color.z) << 16) | (to_channel(color.y) << 8) | to_channel(color.x);
+}
+
+no::vector2f tile_position(const game_world_room& room, no::vector2i tile) {
+	return (room.index + tile).to<float>() * tile_size_f;
+}
+
+// A hand-made room instead of a generated dungeon, since the generator's random numbers differ between standard libraries.
+// Nothing is simulated, and the animations are left on their first frame.
+game_world_room& build_scene(game_world& world) {
+	world.clear_rooms();
+	auto& room{ world.rooms.emplace_back(world) };
+	room.type = 'f';
+	room.resize(scene_room_size.x, scene_room_size.y);
+	for (int y{ 0 }; y < scene_room_size.y; y++) {
+		for (int x{ 0 }; x < scene_room_size.x; x++) {
+			const bool is_border{ x == 0 || y == 0 || x == scene_room_size.x - 1 || y == scene_room_size.y - 1 };
+			const bool is_pillar{ (x == 6 || x == 7) && (y == 4 || y == 5) };
+			room.set_tile(x, y, is_border || is_pillar ? tile_type::wall : tile_type::floor);
+		}
+	}
+	room.initial_monsters_spawned = true;
+	for (const auto& placed : scene_monsters) {
+		auto& monster{ world.spawn_monster(room, placed.type) };
+		monster.transform.position = tile_position(room, placed.tile);
+		monster.facing_right = placed.facing_right;
+		monster.last_animation = animation_type::idle;
+		monster.animation.frames = monster_type::animation_frames(placed.type, animation_type::idle);
+	}
+	const no::vector2i chest_tiles[]{ { 4, 8 }, { 11, 8 } };
+	for (int i{ 0 }; i < 2; i++) {
+		auto& chest{ room.chests.emplace_back() };
+		chest.transform.position = tile_position(room, chest_tiles[i]);
+		chest.is_crate = i == 1;
+		chest.id = world.next_object_id();
+		chest.world = &world;
+		chest.room = &room;
+	}
+	room.spawn_attack(true, item_type::fire_staff, 1, tile_position(room, { 5, 3 }), 16.0f, 0.0f, 1000);
+	room.pending_events.clear();
+	auto& player{ world.player };
+	player.transform.position = tile_position(room, { 6, 7 });
+	player.room = &room;
+	player.facing_right = true;
+	player.last_animation = animation_type::idle;
+	player.animation.frames = 4;
+	player.give_item(item_type::sword, 0);
+	return room;
+}
+
+}
+
+std::string software_frame::summary() const {
+	const auto timings{ target.last_timings() };
+	return STRING(timings.quads << " quads, submit " << submit_ns / 1000 << " us, raster " << timings.raster_ns / 1000 << " us");
+}
+
+software_frame draw_software_frame(no::vector2i size, no::vector3f background, job_system& jobs, const std::function<void()>& draw) {
+	software_frame frame{ software_renderer{ size.x, size.y } };
+	frame.target.clear(to_pixel(background));
+	const auto submit_start{ std::chrono::steady_clock::now() };
+	draw_target::set_software(&frame.target);
+	draw();
+	draw_target::set_software(nullptr);
+	frame.submit_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - submit_start).count();
+	frame.target.flush(jobs);
+	return frame;
+}
+
+bool render_headless_software_frame(const std::string& output_path, const std::string& golden_path, bool write_golden) {
+	auto world{ std::make_unique<game_world>() };
+	const auto& room{ build_scene(*world) };
+	draw_target::set_headless(true);
+	std::optional<software_frame> frame;
+	{
+		game_renderer renderer{ *world };
+		renderer.camera.zoom = headless_zoom;
+		renderer.camera.transform.scale = headless_frame_size.to<float>();
+		// Centered on the room, since the camera only reaches the player after chasing it for a while.
+		const no::vector2f room_size{ static_cast<float>(room.width() * tile_size), static_cast<float>(room.height() * tile_size) };
+		renderer.camera.transform.position = tile_position(room, { 0, 0 }) + room_size / 2.0f - renderer.camera.size() / 2.0f;
+		frame = draw_software_frame(headless_frame_size, room_background_color(room.type).value(), world->jobs, [&] {
+			renderer.draw();
+		});
+	}
+	draw_target::set_headless(false);
+	if (!frame->target.save_png(output_path)) {
+		LOG_WARNING(log_category::render, "Failed to write the software frame to %s", output_path.c_str());
+	}
+	if (write_golden) {
+		const auto golden_directory{ std::filesystem::path{ golden_path }.parent_path() };
+		if (!golden_directory.empty()) {
+			std::filesystem::create_directories(golden_directory);
+		}
+		const bool written{ frame->target.save_png(golden_path) };
+		if (written) {
+			LOG_INFO(log_category::render, "Software frame: %s, written as golden image %s", frame->summary().c_str(), golden_path.c_str());
+		} else {
+			LOG_WARNING(log_category::render, "Failed to write the golden image %s", golden_path.c_str());
+		}
+		return written;
+	}
+	const int mismatches{ frame->target.compare_with_golden(golden_path, golden_tolerance) };
+	if (mismatches < 0) {
+		LOG_WARNING(log_category::render, "Software frame: %s, no golden image at %s", frame->summary().c_str(), golden_path.c_str());
+	} else {
+		LOG_INFO(log_category::render, "Software frame: %s, %i pixels differ from golden image", frame->summary().c_str(), mismatches);
+	}
+	return mismatches == 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "software_renderer.hpp"
+
+#include <functional>
+#include <string>
+
+class job_system;
+
+struct software_frame {
+
+	software_renderer target;
+	long long submit_ns{ 0 };
+
+	std::string summary() const;
+
+};
+
+// Clears a frame to the background color, and rasterises what the draw function draws while the frame is the draw target.
+software_frame draw_software_frame(no::vector2i size, no::vector3f background, job_system& jobs, const std::function<void()>& draw);
+
+// Draws a fixed scene through the game's renderer without opening a window, so nothing is sent to the engine
+// and the textures are loaded straight from their files. The UI isn't drawn, since it needs a running game.
+// The frame is saved as a PNG file and compared with the golden image, or replaces it if write_golden is set.
+// Returns false if the frame differs from the golden image, or if there is none.
+bool render_headless_software_frame(const std::string& output_path, const std::string& golden_path, bool write_golden);
@@ -0,0 +1,385 @@
+#include "software_renderer.hpp"
+#include "job_system.hpp"
+#include "surface.hpp"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+// Small enough that a band of dense sprites doesn't keep one thread busy while the others are done.
+constexpr int rows_per_band{ 16 };
+
+long long nanoseconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int channel(uint32_t pixel, int index) {
+	return static_cast<int>((pixel >> (index * 8)) & 0xFF);
+}
+
+void append_big_endian(std::vector<unsigned char>& bytes, uint32_t value) {
+	for (int shift{ 24 }; shift >= 0; shift -= 8) {
+		bytes.push_back(static_cast<unsigned char>((value >> shift) & 0xFF));
+	}
+}
+
+uint32_t crc32(const unsigned char* bytes, size_t size, uint32_t crc = 0) {
+	static const auto table{ [] {
+		std::array<uint32_t, 256> table{};
+		for (uint32_t i{ 0 }; i < 256; i++) {
+			uint32_t value{ i };
+			for (int bit{ 0 }; bit < 8; bit++) {
+				value = (value & 1) ? 0xEDB88320 ^ (value >> 1) : value >> 1;
+			}
+			table[i] = value;
+		}
+		return table;
+	}() };
+	crc = ~crc;
+	for (size_t i{ 0 }; i < size; i++) {
+		crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+uint32_t adler32(const std::vector<unsigned char>& bytes) {
+	uint32_t a{ 1 };
+	uint32_t b{ 0 };
+	for (const unsigned char byte : bytes) {
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	return (b << 16) | a;
+}
+
+// Writes bits from the least significant end, like deflate expects.
+class deflate_bit_writer {
+public:
+
+	std::vector<unsigned char>& bytes;
+
+	deflate_bit_writer(std::vector<unsigned char>& bytes) : bytes{ bytes } {
+
+	}
+
+	void write(uint32_t bits, int count) {
+		buffer |= bits << buffered;
+		buffered += count;
+		while (buffered >= 8) {
+			bytes.push_back(static_cast<unsigned char>(buffer & 0xFF));
+			buffer >>= 8;
+			buffered -= 8;
+		}
+	}
+
+	// Huffman codes are stored from the most significant bit.
+	void write_code(uint32_t code, int length) {
+		uint32_t reversed{ 0 };
+		for (int i{ 0 }; i < length; i++) {
+			reversed |= ((code >> i) & 1) << (length - 1 - i);
+		}
+		write(reversed, length);
+	}
+
+	void finish() {
+		if (buffered > 0) {
+			bytes.push_back(static_cast<unsigned char>(buffer & 0xFF));
+		}
+		buffer = 0;
+		buffered = 0;
+	}
+
+private:
+
+	uint32_t buffer{ 0 };
+	int buffered{ 0 };
+
+};
+
+constexpr int deflate_length_base[]{ 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+constexpr int deflate_length_extra[]{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+constexpr int deflate_distance_base[]{
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+constexpr int deflate_distance_extra[]{ 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// The fixed Huffman code of a literal, length or end of block symbol.
+void write_fixed_symbol(deflate_bit_writer& writer, int symbol) {
+	if (symbol < 144) {
+		writer.write_code(0x30 + symbol, 8);
+	} else if (symbol < 256) {
+		writer.write_code(0x190 + symbol - 144, 9);
+	} else if (symbol < 280) {
+		writer.write_code(symbol - 256, 7);
+	} else {
+		writer.write_code(0xC0 + symbol - 280, 8);
+	}
+}
+
+void write_match(deflate_bit_writer& writer, int length, int distance) {
+	int length_code{ 28 };
+	while (deflate_length_base[length_code] > length) {
+		length_code--;
+	}
+	write_fixed_symbol(writer, 257 + length_code);
+	writer.write(length - deflate_length_base[length_code], deflate_length_extra[length_code]);
+	int distance_code{ 29 };
+	while (deflate_distance_base[distance_code] > distance) {
+		distance_code--;
+	}
+	writer.write_code(distance_code, 5);
+	writer.write(distance - deflate_distance_base[distance_code], deflate_distance_extra[distance_code]);
+}
+
+// One deflate block with the fixed Huffman codes, and matches found through a table of the last position of each 3 byte hash.
+// Frames are mostly flat colors and repeated tiles, so this is enough to keep them small.
+std::vector<unsigned char> zlib_compress(const std::vector<unsigned char>& input) {
+	constexpr int window_size{ 32768 };
+	constexpr int max_match{ 258 };
+	constexpr int hash_bits{ 15 };
+	std::vector<unsigned char> output{ 0x78, 0x01 };
+	deflate_bit_writer writer{ output };
+	writer.write(1, 1); // final block
+	writer.write(1, 2); // fixed Huffman codes
+	std::vector<int> last_position(1 << hash_bits, -1);
+	const auto hash_at{ [&](size_t i) {
+		const uint32_t value{ static_cast<uint32_t>(input[i]) | (static_cast<uint32_t>(input[i + 1]) << 8) | (static_cast<uint32_t>(input[i + 2]) << 16) };
+		return static_cast<int>((value * 2654435761u) >> (32 - hash_bits));
+	} };
+	size_t i{ 0 };
+	while (i < input.size()) {
+		int match_length{ 0 };
+		int match_distance{ 0 };
+		if (i + 3 <= input.size()) {
+			const int hash{ hash_at(i) };
+			const int candidate{ last_position[hash] };
+			last_position[hash] = static_cast<int>(i);
+			if (candidate >= 0 && static_cast<int>(i) - candidate <= window_size) {
+				const size_t max_length{ std::min<size_t>(max_match, input.size() - i) };
+				size_t length{ 0 };
+				while (length < max_length && input[candidate + length] == input[i + length]) {
+					length++;
+				}
+				if (length >= 3) {
+					match_length = static_cast<int>(length);
+					match_distance = static_cast<int>(i) - candidate;
+				}
+			}
+		}
+		if (match_length == 0) {
+			write_fixed_symbol(writer, input[i]);
+			i++;
+			continue;
+		}
+		write_match(writer, match_length, match_distance);
+		for (size_t end{ i + match_length }, next{ i + 1 }; next < end && next + 3 <= input.size(); next++) {
+			last_position[hash_at(next)] = static_cast<int>(next);
+		}
+		i += match_length;
+	}
+	write_fixed_symbol(writer, 256);
+	writer.finish();
+	append_big_endian(output, adler32(input));
+	return output;
+}
+
+void write_png_chunk(std::ofstream& file, const char* type, const std::vector<unsigned char>& data) {
+	std::vector<unsigned char> chunk;
+	chunk.reserve(data.size() + 12);
+	append_big_endian(chunk, static_cast<uint32_t>(data.size()));
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	// The checksum covers the type and data, but not the length.
+	append_big_endian(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+	file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+}
+
+uint32_t blend(uint32_t destination, uint32_t source, const no::vector4f& color) {
+	const float alpha{ static_cast<float>(channel(source, 3)) / 255.0f * color.w };
+	if (alpha <= 0.0f) {
+		return destination;
+	}
+	const float tint[3]{ color.x, color.y, color.z };
+	uint32_t result{ 0 };
+	for (int i{ 0 }; i < 3; i++) {
+		const float src{ static_cast<float>(channel(source, i)) * tint[i] };
+		const float dst{ static_cast<float>(channel(destination, i)) };
+		const int value{ static_cast<int>(src * alpha + dst * (1.0f - alpha)) };
+		result |= static_cast<uint32_t>(std::min(std::max(value, 0), 255)) << (i * 8);
+	}
+	const int dst_alpha{ channel(destination, 3) };
+	const int out_alpha{ static_cast<int>(alpha * 255.0f + static_cast<float>(dst_alpha) * (1.0f - alpha)) };
+	result |= static_cast<uint32_t>(std::min(out_alpha, 255)) << 24;
+	return result;
+}
+
+}
+
+software_renderer::software_renderer(int width, int height) : frame_width{ width }, frame_height{ height } {
+	frame.resize(width * height);
+}
+
+int software_renderer::width() const {
+	return frame_width;
+}
+
+int software_renderer::height() const {
+	return frame_height;
+}
+
+const std::vector<uint32_t>& software_renderer::pixels() const {
+	return frame;
+}
+
+software_renderer::timings software_renderer::last_timings() const {
+	return finished_timings;
+}
+
+bool software_renderer::has_texture(int texture) const {
+	return textures.find(texture) != textures.end();
+}
+
+void software_renderer::set_texture(int texture, const texture_pixels& pixels) {
+	textures[texture] = pixels;
+}
+
+void software_renderer::set_view(no::vector2f position, no::vector2f size) {
+	view_position = position;
+	view_scale = { static_cast<float>(frame_width) / size.x, static_cast<float>(frame_height) / size.y };
+}
+
+void software_renderer::bind_texture(int texture) {
+	bound_texture = texture;
+}
+
+void software_renderer::set_color(const no::vector4f& new_color) {
+	color = new_color;
+}
+
+void software_renderer::clear(uint32_t clear_color) {
+	std::fill(frame.begin(), frame.end(), clear_color);
+	commands.clear();
+	queued_quads = 0;
+}
+
+void software_renderer::draw_quad(no::vector2f position, no::vector2f size, const no::vector4f& uv, const no::vector4f& tint) {
+	auto& quad{ commands.emplace_back() };
+	quad.min = (position - view_position) * view_scale;
+	quad.max = (position + size - view_position) * view_scale;
+	quad.uv_min = uv.xy;
+	quad.uv_max = uv.xy + uv.zw;
+	// Negative sizes are used to mirror sprites.
+	if (quad.max.x < quad.min.x) {
+		std::swap(quad.min.x, quad.max.x);
+		std::swap(quad.uv_min.x, quad.uv_max.x);
+	}
+	if (quad.max.y < quad.min.y) {
+		std::swap(quad.min.y, quad.max.y);
+		std::swap(quad.uv_min.y, quad.uv_max.y);
+	}
+	quad.color = { color.x * tint.x, color.y * tint.y, color.z * tint.z, color.w * tint.w };
+	quad.texture = bound_texture;
+	queued_quads++;
+}
+
+void software_renderer::flush(job_system& jobs) {
+	const auto start{ std::chrono::steady_clock::now() };
+	const int bands{ (frame_height + rows_per_band - 1) / rows_per_band };
+	jobs.parallel_for(bands, [this](int band) {
+		const int first_row{ band * rows_per_band };
+		const int last_row{ std::min(first_row + rows_per_band, frame_height) };
+		for (const auto& quad : commands) {
+			rasterise(quad, first_row, last_row);
+		}
+	});
+	commands.clear();
+	finished_timings.raster_ns = nanoseconds_since(start);
+	finished_timings.quads = queued_quads;
+	queued_quads = 0;
+}
+
+void software_renderer::rasterise(const quad_command& quad, int first_row, int last_row) {
+	const auto found{ textures.find(quad.texture) };
+	if (found == textures.end() || found->second.pixels.empty()) {
+		return;
+	}
+	const auto& texture{ found->second };
+	const int min_x{ std::max(0, static_cast<int>(std::ceil(quad.min.x - 0.5f))) };
+	const int max_x{ std::min(frame_width, static_cast<int>(std::ceil(quad.max.x - 0.5f))) };
+	const int min_y{ std::max(first_row, static_cast<int>(std::ceil(quad.min.y - 0.5f))) };
+	const int max_y{ std::min(last_row, static_cast<int>(std::ceil(quad.max.y - 0.5f))) };
+	if (min_x >= max_x || min_y >= max_y) {
+		return;
+	}
+	const no::vector2f size{ quad.max - quad.min };
+	for (int y{ min_y }; y < max_y; y++) {
+		const float v_step{ (static_cast<float>(y) + 0.5f - quad.min.y) / size.y };
+		const float v{ quad.uv_min.y + (quad.uv_max.y - quad.uv_min.y) * v_step };
+		const int texel_y{ std::min(std::max(static_cast<int>(v * static_cast<float>(texture.height)), 0), texture.height - 1) };
+		const uint32_t* texture_row{ &texture.pixels[texel_y * texture.width] };
+		uint32_t* frame_row{ &frame[y * frame_width] };
+		for (int x{ min_x }; x < max_x; x++) {
+			const float u_step{ (static_cast<float>(x) + 0.5f - quad.min.x) / size.x };
+			const float u{ quad.uv_min.x + (quad.uv_max.x - quad.uv_min.x) * u_step };
+			const int texel_x{ std::min(std::max(static_cast<int>(u * static_cast<float>(texture.width)), 0), texture.width - 1) };
+			frame_row[x] = blend(frame_row[x], texture_row[texel_x], quad.color);
+		}
+	}
+}
+
+int software_renderer::compare_with_golden(const std::string& path, int tolerance) const {
+	if (!std::filesystem::exists(path)) {
+		return -1;
+	}
+	const no::surface golden{ path };
+	if (golden.width() != frame_width || golden.height() != frame_height) {
+		return frame_width * frame_height;
+	}
+	int mismatches{ 0 };
+	for (int y{ 0 }; y < frame_height; y++) {
+		for (int x{ 0 }; x < frame_width; x++) {
+			const uint32_t expected{ golden.at(x, y) };
+			const uint32_t actual{ frame[y * frame_width + x] };
+			for (int i{ 0 }; i < 4; i++) {
+				if (std::abs(channel(expected, i) - channel(actual, i)) > tolerance) {
+					mismatches++;
+					break;
+				}
+			}
+		}
+	}
+	return mismatches;
+}
+
+bool software_renderer::save_png(const std::string& path) const {
+	std::ofstream file{ path, std::ios::binary };
+	if (!file.is_open()) {
+		return false;
+	}
+	// Each row starts with its filter type, which is always none.
+	std::vector<unsigned char> rows;
+	rows.reserve(frame.size() * 4 + frame_height);
+	for (int y{ 0 }; y < frame_height; y++) {
+		rows.push_back(0);
+		for (int x{ 0 }; x < frame_width; x++) {
+			const uint32_t pixel{ frame[y * frame_width + x] };
+			for (int i{ 0 }; i < 4; i++) {
+				rows.push_back(static_cast<unsigned char>(channel(pixel, i)));
+			}
+		}
+	}
+	std::vector<unsigned char> header;
+	append_big_endian(header, static_cast<uint32_t>(frame_width));
+	append_big_endian(header, static_cast<uint32_t>(frame_height));
+	header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8 bits per channel, RGBA, no interlacing
+	const unsigned char signature[]{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+	write_png_chunk(file, "IHDR", header);
+	write_png_chunk(file, "IDAT", zlib_compress(rows));
+	write_png_chunk(file, "IEND", {});
+	return file.good();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "draw.hpp"
+
+#include <unordered_map>
+
+class job_system;
+
+// Rasterises textured quads into an RGBA buffer on the CPU. The game's draw calls reach it through draw_target.
+// Only covers what the game draws: axis-aligned quads, nearest sampling, alpha blending and a color multiplier.
+// Quads are queued by draw calls and rasterised on flush(), with the frame split into horizontal bands that the job system's threads take turns on.
+class software_renderer {
+public:
+
+	struct timings {
+		long long raster_ns{ 0 };
+		int quads{ 0 };
+	};
+
+	struct texture_pixels {
+		int width{ 0 };
+		int height{ 0 };
+		std::vector<uint32_t> pixels;
+	};
+
+	software_renderer(int width, int height);
+
+	int width() const;
+	int height() const;
+	const std::vector<uint32_t>& pixels() const;
+	timings last_timings() const;
+
+	// Textures are identified by the engine's texture id.
+	bool has_texture(int texture) const;
+	void set_texture(int texture, const texture_pixels& pixels);
+
+	void set_view(no::vector2f position, no::vector2f size);
+	void bind_texture(int texture);
+	void set_color(const no::vector4f& color);
+
+	void clear(uint32_t color);
+	// The tint is multiplied with the color, like a vertex color.
+	void draw_quad(no::vector2f position, no::vector2f size, const no::vector4f& uv, const no::vector4f& tint = 1.0f);
+	void flush(job_system& jobs);
+
+	// Returns the number of pixels differing by more than the tolerance on any channel, or -1 if the golden image is missing.
+	int compare_with_golden(const std::string& path, int tolerance) const;
+	// Returns false if the file couldn't be written.
+	bool save_png(const std::string& path) const;
+
+private:
+
+	struct quad_command {
+		no::vector2f min;
+		no::vector2f max;
+		no::vector2f uv_min;
+		no::vector2f uv_max;
+		no::vector4f color;
+		int texture{ -1 };
+	};
+
+	void rasterise(const quad_command& quad, int first_row, int last_row);
+
+	int frame_width{ 0 };
+	int frame_height{ 0 };
+	std::vector<uint32_t> frame;
+	std::unordered_map<int, texture_pixels> textures;
+	std::vector<quad_command> commands;
+
+	no::vector2f view_position;
+	no::vector2f view_scale{ 1.0f };
+	no::vector4f color{ 1.0f };
+	int bound_texture{ -1 };
+	int queued_quads{ 0 };
+	timings finished_timings;
+
+};
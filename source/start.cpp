@@ -1,5 +1,11 @@
 #include "game.hpp"
 #include "assets.hpp"
+#include "audio_render.hpp"
+#include "software_frame.hpp"
+#include "allocation_replay.hpp"
+#include "allocation_tracker.hpp"
+#include "async_log.hpp"
+#include "command_line.hpp"
 
 #define DEV_VERSION 0
 
@@ -10,9 +16,52 @@ void configure() {
 	no::register_all_textures();
 	no::register_font("leo", 16);
 	no::register_shader("sprite");
-	no::register_sound("bg");
+}
+
+// --allocation-budget-world=N and the same for the renderer and UI. A negative budget is unlimited.
+void set_allocation_budgets() {
+	constexpr std::pair<int, const char*> options[]{
+		{ allocation_subsystem::world, "allocation-budget-world" },
+		{ allocation_subsystem::renderer, "allocation-budget-renderer" },
+		{ allocation_subsystem::ui, "allocation-budget-ui" }
+	};
+	for (const auto& [subsystem, option] : options) {
+		if (const auto budget{ get_command_line_int(option) }) {
+			allocation_tracker::set_budget(subsystem, budget.value());
+		}
+	}
 }
 
 void start() {
+	set_allocation_budgets();
+	if (const auto wav_path{ get_command_line_string("audio-render") }) {
+		// Batch run: mix a scripted sequence to a WAV file as fast as possible, without opening a window.
+		async_log::start("log.html", "log.txt");
+		const bool written{ render_audio_script(wav_path->empty() ? "audio_render.wav" : wav_path.value(), get_command_line_int("audio-render-seconds").value_or(30)) };
+		async_log::stop();
+		std::exit(written ? 0 : 1);
+	}
+	if (const auto frame_path{ get_command_line_string("software-frame") }) {
+		// Batch run: draw a fixed scene with the CPU rasteriser without opening a window, and fail if it differs from the golden image.
+		// With --write-golden, the frame becomes the new golden image instead.
+		async_log::start("log.html", "log.txt");
+		const bool passed{ render_headless_software_frame(frame_path->empty() ? "software_frame.png" : frame_path.value(),
+			get_command_line_string("golden").value_or(no::asset_path("golden/frame.png")), has_command_line_option("write-golden")) };
+		async_log::stop();
+		std::exit(passed ? 0 : 1);
+	}
+	if (has_command_line_option("allocation-replay")) {
+		// Batch run: simulate a scripted session without a window, and fail if a steady-state frame allocates more than its budget.
+		async_log::start("log.html", "log.txt");
+#if WITH_ALLOCATION_TRACKING
+		allocation_replay replay;
+		const int exit_code{ replay.run(get_command_line_int("allocation-replay").value_or(600)) > 0 ? 1 : 0 };
+#else
+		LOG_WARNING(log_category::performance, "Allocation replay needs a build with WITH_ALLOCATION_TRACKING");
+		const int exit_code{ 2 };
+#endif
+		async_log::stop();
+		std::exit(exit_code);
+	}
 	no::create_state<game_state>("Inmate", 800, 600, 0, true);
 }
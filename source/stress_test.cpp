@@ -0,0 +1,178 @@
+#include "stress_test.hpp"
+#include "game.hpp"
+#include "item.hpp"
+#include "async_log.hpp"
+
+namespace {
+
+constexpr int bot_direction_ticks{ ticks_per_second };
+constexpr int report_ticks{ ticks_per_second * 2 };
+
+constexpr int stress_monster_types[]{
+	monster_type::skeleton,
+	monster_type::knight,
+	monster_type::dark_wizard,
+	monster_type::toxic_wizard,
+	monster_type::big_fire_slime,
+	monster_type::small_fire_slime,
+	monster_type::fire_imp
+};
+
+}
+
+stress_test::stress_test(game_state& game) : game{ game } {
+
+}
+
+void stress_test::start() {
+	if (running) {
+		stop();
+	}
+	game.enter_dungeon('f');
+#if POST_LD_FEATURE_KILL_COUNT
+	game.monster_count = 0;
+	for (const auto& room : game.world.rooms) {
+		game.monster_count += static_cast<int>(room.monsters.size());
+	}
+#endif
+	refill_monsters();
+	saved_inventory = game.world.player.save_inventory();
+	game.world.player.give_item(item_type::fire_staff, -1);
+	// Every room is simulated and drawn, not only the one the bot is in.
+	was_showing_all_rooms = game.show_all_rooms;
+	game.show_all_rooms = true;
+	ticks = 0;
+	running = true;
+	LOG_INFO(log_category::performance, "Stress test started with %i monsters and %i projectiles per room", monsters_per_room, projectiles_per_room);
+}
+
+void stress_test::stop() {
+	if (!running) {
+		return;
+	}
+	running = false;
+	game.show_all_rooms = was_showing_all_rooms;
+	game.world.player.load_inventory(saved_inventory);
+	game.enter_lobby();
+}
+
+bool stress_test::is_running() const {
+	return running;
+}
+
+void stress_test::update() {
+	if (!running) {
+		return;
+	}
+	refill_monsters();
+	top_up_projectiles();
+	update_bot();
+	ticks++;
+	if (ticks % report_ticks == 0) {
+		update_report();
+	}
+}
+
+const std::string& stress_test::report() const {
+	return last_report;
+}
+
+int stress_test::fill_room_with_monsters(int room_index) {
+	auto& world{ game.world };
+	auto& room{ world.rooms[room_index] };
+	const int initial_count{ static_cast<int>(room.monsters.size()) };
+	if (initial_count >= monsters_per_room) {
+		return 0;
+	}
+	room.monsters.reserve(monsters_per_room);
+	for (int i{ initial_count }; i < monsters_per_room; i++) {
+		// Crowded rooms run out of empty positions quickly, so fall back to any floor tile.
+		auto position{ room.find_empty_position() };
+		if (!position) {
+			const no::vector2i tile{ world.random.next<int>(1, room.width() - 2), world.random.next<int>(1, room.height() - 2) };
+			if (!room.tile_at(tile.x, tile.y).is_only(tile_type::floor)) {
+				continue;
+			}
+			position = (room.index + tile).to<float>() * tile_size_f;
+		}
+		auto& monster{ world.spawn_monster(room, stress_monster_types[i % std::size(stress_monster_types)]) };
+		monster.transform.position = position.value();
+	}
+	room.initial_monsters_spawned = true;
+	world.index_room_objects(room);
+	return static_cast<int>(room.monsters.size()) - initial_count;
+}
+
+void stress_test::refill_monsters() {
+	// The bot and the projectiles kill monsters all the time, so the load would otherwise drop as the test runs.
+	for (int i{ 0 }; i < static_cast<int>(game.world.rooms.size()); i++) {
+		if (game.world.rooms[i].is_boss_room) {
+			continue;
+		}
+		const int spawned{ fill_room_with_monsters(i) };
+#if POST_LD_FEATURE_KILL_COUNT
+		game.monster_count += spawned;
+#endif
+	}
+}
+
+void stress_test::top_up_projectiles() {
+	auto& world{ game.world };
+	const int projectiles{ std::min(projectiles_per_room, game_world_room::active_attack_pool::capacity) };
+	for (auto& room : world.rooms) {
+		if (room.is_boss_room) {
+			continue;
+		}
+		while (room.attacks.size() < projectiles) {
+			// Added directly instead of through spawn_attack, which would also play a sound for each.
+			auto attack{ room.attacks.add() };
+			const bool by_player{ world.random.chance(0.5f) };
+			attack->by_player = by_player;
+			attack->type = by_player ? item_type::fire_staff : monster_type::dark_wizard;
+			attack->position = {
+				static_cast<float>((room.left() + world.random.next<int>(1, room.width() - 2)) * tile_size),
+				static_cast<float>((room.top() + world.random.next<int>(1, room.height() - 2)) * tile_size)
+			};
+			attack->origin = attack->position;
+			attack->size = 8.0f;
+			attack->speed = { world.random.chance(0.5f) ? 3.0f : -3.0f, world.random.chance(0.5f) ? 3.0f : -3.0f };
+			attack->max_life_ticks = ticks_per_second;
+			attack->health = 3;
+		}
+	}
+}
+
+void stress_test::update_bot() {
+	auto& player{ game.world.player };
+	// The bot can't die, so the test keeps running at full load.
+	player.stats.health = player.final_stats().max_health;
+	player.stats.mana = player.final_stats().max_mana;
+	if (ticks % bot_direction_ticks == 0) {
+		bot_direction = game.world.random.next<int>(0, 7);
+	}
+	const bool left{ bot_direction == 0 || bot_direction == 4 || bot_direction == 6 };
+	const bool right{ bot_direction == 1 || bot_direction == 5 || bot_direction == 7 };
+	const bool up{ bot_direction == 2 || bot_direction == 4 || bot_direction == 5 };
+	const bool down{ bot_direction == 3 || bot_direction == 6 || bot_direction == 7 };
+	player.move(left, right, up, down);
+	if (player.room) {
+		player.attack();
+	}
+}
+
+void stress_test::update_report() {
+	int monsters{ 0 };
+	int projectiles{ 0 };
+	for (const auto& room : game.world.rooms) {
+		monsters += static_cast<int>(room.monsters.size());
+		projectiles += room.attacks.size();
+	}
+	const int entities{ std::max(1, monsters + projectiles) };
+	const auto update_ms{ game.telemetry.get_percentiles(frame_phase::update) };
+	const auto draw_ms{ game.telemetry.get_percentiles(frame_phase::draw) };
+	const int update_ns_per_entity{ static_cast<int>(update_ms.p50 * 1000000.0f / static_cast<float>(entities)) };
+	const int draw_ns_per_entity{ static_cast<int>(draw_ms.p50 * 1000000.0f / static_cast<float>(entities)) };
+	last_report = STRING(monsters << " monsters, " << projectiles << " projectiles. Update p50 " << update_ms.p50 << " ms ("
+		<< update_ns_per_entity << " ns/entity), draw p50 " << draw_ms.p50 << " ms (" << draw_ns_per_entity << " ns/entity)");
+	LOG_INFO(log_category::performance, "Stress test: %s", last_report.c_str());
+}
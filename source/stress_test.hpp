@@ -0,0 +1,45 @@
+#pragma once
+
+#include "player.hpp"
+
+#include <string>
+
+class game_state;
+
+// Fills every room of a dungeon with far more monsters and projectiles than the game would spawn, and lets a bot play.
+// Used to find out how the update and draw cost scales with the number of entities.
+// Boss rooms are left alone, since killing a boss ends the dungeon.
+class stress_test {
+public:
+
+	int monsters_per_room{ 200 };
+	int projectiles_per_room{ 128 };
+
+	stress_test(game_state& game);
+
+	void start();
+	void stop();
+	bool is_running() const;
+
+	// Replaces the player controller while running.
+	void update();
+
+	const std::string& report() const;
+
+private:
+
+	int fill_room_with_monsters(int room_index);
+	void refill_monsters();
+	void top_up_projectiles();
+	void update_bot();
+	void update_report();
+
+	game_state& game;
+	bool running{ false };
+	bool was_showing_all_rooms{ false };
+	player_object::inventory saved_inventory;
+	int ticks{ 0 };
+	int bot_direction{ 0 };
+	std::string last_report;
+
+};
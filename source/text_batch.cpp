@@ -0,0 +1,180 @@
+#include "text_batch.hpp"
+
+constexpr int atlas_width{ 512 };
+constexpr int max_cached_layouts{ 64 };
+
+glyph_atlas::glyph_atlas(no::font& font, uint32_t color) {
+	struct rendered_glyph {
+		int width{ 0 };
+		int height{ 0 };
+		std::vector<uint32_t> pixels;
+		no::vector2i offset;
+	};
+	std::vector<rendered_glyph> rendered;
+	no::vector2i cursor;
+	int row_height{ 0 };
+	for (char character{ first_character }; character <= last_character; character++) {
+		const no::surface surface{ font.render(std::string(1, character), color) };
+		auto& glyph{ rendered.emplace_back() };
+		glyph.width = surface.width();
+		glyph.height = surface.height();
+		glyph.pixels.reserve(surface.count());
+		for (int y{ 0 }; y < glyph.height; y++) {
+			for (int x{ 0 }; x < glyph.width; x++) {
+				glyph.pixels.push_back(surface.at(x, y));
+			}
+		}
+		if (cursor.x + glyph.width > atlas_width) {
+			cursor.x = 0;
+			cursor.y += row_height + 1;
+			row_height = 0;
+		}
+		glyph.offset = cursor;
+		cursor.x += glyph.width + 1;
+		row_height = std::max(row_height, glyph.height);
+		glyph_height = std::max(glyph_height, static_cast<float>(glyph.height));
+	}
+	const int atlas_height{ std::max(1, cursor.y + row_height) };
+	std::vector<uint32_t> pixels(atlas_width * atlas_height);
+	for (const auto& glyph : rendered) {
+		for (int y{ 0 }; y < glyph.height; y++) {
+			for (int x{ 0 }; x < glyph.width; x++) {
+				pixels[(glyph.offset.y + y) * atlas_width + glyph.offset.x + x] = glyph.pixels[y * glyph.width + x];
+			}
+		}
+	}
+	const no::vector2f atlas_size{ static_cast<float>(atlas_width), static_cast<float>(atlas_height) };
+	for (int i{ 0 }; i < static_cast<int>(rendered.size()); i++) {
+		const auto& glyph{ rendered[i] };
+		glyphs[i].size = { static_cast<float>(glyph.width), static_cast<float>(glyph.height) };
+		glyphs[i].uv = {
+			static_cast<float>(glyph.offset.x) / atlas_size.x,
+			static_cast<float>(glyph.offset.y) / atlas_size.y,
+			glyphs[i].size.x / atlas_size.x,
+			glyphs[i].size.y / atlas_size.y
+		};
+	}
+	// Spaces may render as an empty surface, but still need to advance the cursor.
+	auto& space{ glyphs[' ' - first_character] };
+	if (space.size.x < 1.0f) {
+		space.size = { glyph_height / 3.0f, glyph_height };
+		space.uv = 0.0f;
+	}
+	atlas_texture = draw_target::create_texture({ pixels.data(), atlas_width, atlas_height, no::pixel_format::rgba, no::surface::construct_by::copy });
+}
+
+glyph_atlas::~glyph_atlas() {
+	draw_target::delete_texture(atlas_texture);
+}
+
+int glyph_atlas::texture() const {
+	return atlas_texture;
+}
+
+float glyph_atlas::line_height() const {
+	return glyph_height;
+}
+
+const glyph_atlas::glyph& glyph_atlas::get(char character) const {
+	if (character < first_character || character > last_character) {
+		character = '?';
+	}
+	return glyphs[character - first_character];
+}
+
+text_batch::text_batch(no::font& font) : font{ font } {
+
+}
+
+no::vector2f text_batch::size_of(const std::string& text, uint32_t color) {
+	return layout(page(color), text).size;
+}
+
+void text_batch::add(const std::string& text, uint32_t color, no::vector2f position, float scale) {
+	auto& color_page{ page(color) };
+	auto& label{ color_page.labels.emplace_back() };
+	label.layout = &layout(color_page, text);
+	label.position = position;
+	label.scale = scale;
+}
+
+void text_batch::draw() {
+	draw_target::set_color(1.0f);
+	draw_target::set_model(no::transform2{ 0.0f, 1.0f });
+	for (auto& [color, page] : pages) {
+		if (page.labels != page.last_labels) {
+			page.shape.clear();
+			no::sprite_vertex top_left;
+			no::sprite_vertex top_right;
+			no::sprite_vertex bottom_right;
+			no::sprite_vertex bottom_left;
+			for (const auto& label : page.labels) {
+				for (const auto& quad : label.layout->quads) {
+					const no::vector2f position{ label.position + quad.position * label.scale };
+					const no::vector2f size{ quad.size * label.scale };
+					top_left.position = position;
+					top_right.position = { position.x + size.x, position.y };
+					bottom_right.position = position + size;
+					bottom_left.position = { position.x, position.y + size.y };
+					top_left.tex_coords = quad.uv.xy;
+					top_right.tex_coords = { quad.uv.x + quad.uv.z, quad.uv.y };
+					bottom_right.tex_coords = quad.uv.xy + quad.uv.zw;
+					bottom_left.tex_coords = { quad.uv.x, quad.uv.y + quad.uv.w };
+					page.shape.append(top_left, top_right, bottom_right, bottom_left);
+				}
+			}
+			page.shape.refresh();
+			std::swap(page.labels, page.last_labels);
+		}
+		page.labels.clear();
+		if (!page.last_labels.empty()) {
+			draw_target::bind_texture(page.atlas->texture());
+			page.shape.draw();
+		}
+		// Drop layouts of strings that are no longer shown, such as old kill counts.
+		if (static_cast<int>(page.layouts.size()) > max_cached_layouts) {
+			for (auto it{ page.layouts.begin() }; it != page.layouts.end();) {
+				it = it->second.used ? std::next(it) : page.layouts.erase(it);
+			}
+		}
+		for (auto& [text, layout] : page.layouts) {
+			layout.used = false;
+		}
+	}
+}
+
+text_batch::atlas_page& text_batch::page(uint32_t color) {
+	auto& color_page{ pages[color] };
+	if (!color_page.atlas) {
+		color_page.atlas = std::make_unique<glyph_atlas>(font, color);
+	}
+	return color_page;
+}
+
+text_batch::text_layout& text_batch::layout(atlas_page& page, const std::string& text) {
+	auto& layout{ page.layouts[text] };
+	layout.used = true;
+	if (!layout.quads.empty() || text.empty()) {
+		return layout;
+	}
+	const float line_height{ page.atlas->line_height() };
+	no::vector2f cursor;
+	for (const char character : text) {
+		if (character == '\n') {
+			cursor.x = 0.0f;
+			cursor.y += line_height;
+			continue;
+		}
+		const auto& glyph{ page.atlas->get(character) };
+		if (character != ' ') {
+			auto& quad{ layout.quads.emplace_back() };
+			quad.position = cursor;
+			quad.size = glyph.size;
+			quad.uv = glyph.uv;
+		}
+		cursor.x += glyph.size.x;
+		layout.size.x = std::max(layout.size.x, cursor.x);
+	}
+	layout.size.y = cursor.y + line_height;
+	return layout;
+}
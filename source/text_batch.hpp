@@ -0,0 +1,94 @@
+#pragma once
+
+#include "draw.hpp"
+#include "draw_target.hpp"
+#include "font.hpp"
+
+#include <memory>
+#include <unordered_map>
+
+// Printable ASCII glyphs of one font and color, rendered once and packed into a single texture.
+class glyph_atlas {
+public:
+
+	struct glyph {
+		no::vector4f uv;
+		no::vector2f size;
+	};
+
+	glyph_atlas(no::font& font, uint32_t color);
+	glyph_atlas(const glyph_atlas&) = delete;
+	glyph_atlas(glyph_atlas&&) = delete;
+	~glyph_atlas();
+
+	glyph_atlas& operator=(const glyph_atlas&) = delete;
+	glyph_atlas& operator=(glyph_atlas&&) = delete;
+
+	int texture() const;
+	float line_height() const;
+	const glyph& get(char character) const;
+
+private:
+
+	static constexpr char first_character{ ' ' };
+	static constexpr char last_character{ '~' };
+
+	int atlas_texture{ -1 };
+	float glyph_height{ 0.0f };
+	glyph glyphs[last_character - first_character + 1];
+
+};
+
+// Lays out strings against glyph atlases and draws all text added in a frame with one draw per atlas.
+// Layouts are cached by string and color, and the vertex buffers are only rebuilt when the submitted labels change.
+class text_batch {
+public:
+
+	text_batch(no::font& font);
+
+	no::vector2f size_of(const std::string& text, uint32_t color = 0xFFFFFFFF);
+	void add(const std::string& text, uint32_t color, no::vector2f position, float scale = 1.0f);
+
+	// Expects the shader and view projection to be set.
+	void draw();
+
+private:
+
+	struct glyph_quad {
+		no::vector2f position;
+		no::vector2f size;
+		no::vector4f uv;
+	};
+
+	struct text_layout {
+		std::vector<glyph_quad> quads;
+		no::vector2f size;
+		bool used{ false };
+	};
+
+	struct submitted_label {
+		const text_layout* layout{ nullptr };
+		no::vector2f position;
+		float scale{ 1.0f };
+
+		bool operator==(const submitted_label& that) const {
+			return layout == that.layout && position == that.position && scale == that.scale;
+		}
+
+	};
+
+	struct atlas_page {
+		std::unique_ptr<glyph_atlas> atlas;
+		std::unordered_map<std::string, text_layout> layouts;
+		std::vector<submitted_label> labels;
+		std::vector<submitted_label> last_labels;
+		quad_list shape;
+	};
+
+	atlas_page& page(uint32_t color);
+	text_layout& layout(atlas_page& page, const std::string& text);
+
+	no::font& font;
+	std::unordered_map<uint32_t, atlas_page> pages;
+
+};
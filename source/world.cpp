@@ -3,8 +3,24 @@
 #include "surface.hpp"
 #include "game.hpp"
 #include "item.hpp"
+#include "profiler.hpp"
 
+#include <cmath>
 #include <filesystem>
+#include <limits>
+
+namespace {
+
+constexpr unsigned short unreachable{ 0xFFFF };
+constexpr unsigned char no_flow{ 8 };
+
+// Orthogonal steps first, so they are preferred over diagonal steps of the same distance.
+const no::vector2i flow_offsets[8]{
+	{ 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 },
+	{ 1, 1 }, { -1, 1 }, { 1, -1 }, { -1, -1 }
+};
+
+}
 
 no::transform2 chest_object::collision_transform() const {
 	no::transform2 collision;
@@ -61,17 +77,23 @@ void game_world_tile::set_bottom_right(unsigned char type) {
 	corner[3] = type;
 }
 
-game_world_room::game_world_room(game_world_room&& that) noexcept : tiles{ std::move(that.tiles) } {
-	std::swap(index, that.index);
-	std::swap(size, that.size);
-	std::swap(world, that.world);
-	std::swap(doors, that.doors);
-	std::swap(monsters, that.monsters);
-	std::swap(initial_monsters_spawned, that.initial_monsters_spawned);
-	std::swap(attacks, that.attacks);
-	std::swap(type, that.type);
-	std::swap(chests, that.chests);
-	std::swap(is_boss_room, that.is_boss_room);
+game_world_room::game_world_room(game_world& world) : world{ &world },
+	random{ static_cast<unsigned long long>(world.random.next<int>(0, std::numeric_limits<int>::max())) }, doors{ world.arena.resource() },
+	monsters{ world.arena.resource() }, chests{ world.arena.resource() }, tiles{ world.arena.resource() },
+	wall_distance{ world.arena.resource() }, spawn_tiles{ world.arena.resource() }, flow_distance{ world.arena.resource() }, flow_direction{ world.arena.resource() }, flow_queue{ world.arena.resource() } {
+
+}
+
+game_world_room::game_world_room(game_world_room&& that) noexcept : world{ that.world }, random{ that.random },
+	events{ that.events }, pending_events{ std::move(that.pending_events) }, index{ that.index },
+	doors{ std::move(that.doors) }, monsters{ std::move(that.monsters) }, attacks{ std::move(that.attacks) },
+	chests{ std::move(that.chests) }, initial_monsters_spawned{ that.initial_monsters_spawned }, type{ that.type },
+	is_boss_room{ that.is_boss_room }, tier{ that.tier }, pending_ticks{ that.pending_ticks }, catching_up{ that.catching_up },
+	collision_boxes{ std::move(that.collision_boxes) }, tiles{ std::move(that.tiles) }, size{ that.size },
+	door_boxes{ std::move(that.door_boxes) }, wall_distance{ std::move(that.wall_distance) },
+	spawn_tiles{ std::move(that.spawn_tiles) }, flow_target{ that.flow_target }, flow_distance{ std::move(that.flow_distance) },
+	flow_direction{ std::move(that.flow_direction) }, flow_queue{ std::move(that.flow_queue) } {
+
 }
 
 void game_world_room::resize(int width, int height) {
@@ -148,14 +170,37 @@ int game_world_room::next_monster_type() {
 	return monster_type::skeleton;
 }
 
-void game_world_room::update() {
+void game_world_room::update(int ticks) {
+	PROFILE_ZONE("game_world_room::update");
+	if (world->player.room == this && !catching_up) {
+		update_flow_field();
+	}
 	for (auto& monster : monsters) {
-		monster.update();
+		monster.update(ticks);
 	}
 	std::sort(monsters.begin(), monsters.end(), [](const monster_object& a, const monster_object& b) {
 		return b.transform.position.y > a.transform.position.y;
 	});
-	process_attacks();
+	refresh_collision_boxes();
+	process_attacks(ticks);
+}
+
+void game_world_room::finish_update() {
+	// The pool and object index are shared by all rooms, so reaping waits until here.
+	reap_dead_monsters();
+	world->index_room_objects(*this);
+	world->events.append(pending_events);
+	pending_events.clear();
+	if (events.player_hit) {
+		world->player.on_being_hit();
+		world->player.stats.health -= events.player_damage;
+	}
+	if (events.boss_item != -1) {
+		world->is_boss_dead = true; // POST-TWEAK: Don't go to lobby immediately.
+		world->boss_item_to_give = events.boss_item;
+		world->events.push({ world_event_type::boss_death, -1, events.boss_item, true });
+	}
+	events = {};
 }
 
 void game_world_room::add_monsters() {
@@ -164,12 +209,10 @@ void game_world_room::add_monsters() {
 		if (is_boss_room) {
 			spawn_count = std::max(4, spawn_count); // POST-BUGFIX: Fix boss not spawning because this was 0.
 		}
+		monsters.reserve(monsters.size() + spawn_count);
 		for (int i{ 0 }; i < spawn_count; i++) {
 			if (auto position{ find_empty_position() }) {
-				auto& monster{ monsters.emplace_back(next_monster_type()) };
-				monster.id = world->next_object_id();
-				monster.world = world;
-				monster.room = this;
+				auto& monster{ world->spawn_monster(*this, next_monster_type()) };
 				if (monster.type == monster_type::fire_boss || monster.type == monster_type::water_boss || monster.type == monster_type::final_boss) {
 					monster.transform.position = index.to<float>() * tile_size_f;
 					monster.transform.position.x += static_cast<float>(width() * tile_size) / 2.0f - 48.0f;
@@ -186,11 +229,28 @@ void game_world_room::add_monsters() {
 					chest.transform.position = position.value();
 					chest.item = world->random.next<int>(0, 36);
 					chest.id = world->next_object_id();
+					chest.world = world;
+					chest.room = this;
 					chest.is_crate = world->random.chance(0.4f); // POST-TWEAK: Chests were too rare.
+					remove_spawn_tiles_near(chest);
 				}
 			}
 		}
 		initial_monsters_spawned = true;
+		world->index_room_objects(*this);
+	}
+}
+
+void game_world_room::reap_dead_monsters() {
+	for (int i{ 0 }; i < static_cast<int>(monsters.size()); i++) {
+		if (monsters[i].can_be_reaped()) {
+			world->remove_monster(monsters[i]);
+			if (i + 1 < static_cast<int>(monsters.size())) {
+				monsters[i] = std::move(monsters.back());
+			}
+			monsters.pop_back();
+			i--;
+		}
 	}
 }
 
@@ -235,102 +295,90 @@ int game_world_room::make_index(int x, int y) const {
 }
 
 void game_world_room::spawn_attack(bool by_player, int type, int attack_health, no::vector2f position, no::vector2f size, no::vector2f speed, int max_life_ms) {
-	auto& attack{ attacks.emplace_back() };
-	attack.type = type;
-	attack.max_life_ms = max_life_ms;
-	attack.origin = position;
-	attack.position = position;
-	attack.size = size;
-	attack.speed = speed;
-	attack.by_player = by_player;
-	attack.health = attack_health;
-	attack.life_timer.start();
-	/*if (attack.by_player) {
-		if (item_type::is_staff(attack.type)) {
-			world->game->play_sound(world->game->magic_sound);
-		} else {
-			world->game->play_sound(world->game->stab_sound);
-		}
-	} else {
-		if (monster_type::is_magic(attack.type)) {
-			world->game->play_sound(world->game->magic_sound);
-		} else {
-			world->game->play_sound(world->game->stab_sound);
-		}
-	}*/
+	auto attack{ attacks.add() };
+	if (!attack) {
+		return;
+	}
+	attack->type = type;
+	attack->max_life_ticks = max_life_ms * ticks_per_second / 1000;
+	attack->origin = position;
+	attack->position = position;
+	attack->size = size;
+	attack->speed = speed;
+	attack->by_player = by_player;
+	attack->health = attack_health;
+	pending_events.push({ world_event_type::attack_spawn, -1, type, by_player, position });
 }
 
-void game_world_room::process_attacks() {
+void game_world_room::process_attacks(int ticks) {
+	PROFILE_ZONE("game_world_room::process_attacks");
 	auto& player{ world->player };
 	const auto player_stats{ player.final_stats() };
 	for (auto& attack : attacks) {
+		// Hits are tested along the whole move, so fast attacks can't pass through anything.
+		// Attacks end at the first wall along their path, and only hit what is before it.
+		no::vector2f delta{ attack.speed * static_cast<float>(ticks) };
+		const auto wall_time{ world->find_tile_mask_along(*this, attack.position + attack.size / 2.0f, delta) };
+		if (wall_time) {
+			delta = delta * wall_time.value();
+		}
 		if (attack.by_player) {
-			for (auto& monster : monsters) {
-				if (monster.dead) {
+			find_swept_hits(attack, delta);
+			for (const auto& hit : swept_hits) {
+				auto& monster{ monsters[hit.monster] };
+				// POST-BUGFIX: Don't hit same enemy twice with same attack.
+				if (attack.has_hit(monster.id)) {
 					continue;
 				}
-				if (monster.collision_transform().collides_with(attack.position, attack.size)) {
-					// POST-BUGFIX: Don't hit same enemy twice with same attack.
-					bool skip_this_one{ false };
-					for (const int hit_id : attack.hits) {
-						if (hit_id == monster.id) {
-							skip_this_one = true;
-							break;
-						}
-					}
-					if (skip_this_one) {
-						continue;
-					}
-					//
-					monster.on_being_hit();
-					attack.hits.push_back(monster.id);
-					float damage{ 0.0f };
-					damage -= monster.stats.defense;
-					damage += player_stats.strength;
-					damage += player_stats.bonus_strength;
-					if (damage <= 0.0f) {
-						damage = player_stats.bonus_strength;
-					}
-					if (world->random.chance(player_stats.critical_strike_chance)) {
-						damage *= 2.0f;
-						world->game->ui.add_hit_splat(monster.id);
-					}
-					monster.stats.health -= damage;
-					if (monster.stats.health <= 0.0f) {
-#if POST_LD_FEATURE_KILL_COUNT
-						world->game->kill_count++;
-#endif
-						monster.dead = true;
-						if (monster.type == monster_type::fire_boss) {
-							//player.give_item(item_type::fire_head, 0);
-							//world->game->enter_lobby();
-							world->is_boss_dead = true; // POST-TWEAK: Don't go to lobby immediately.
-							world->boss_item_to_give = item_type::fire_head;
-							return;
-						} else if (monster.type == monster_type::water_boss) {
-							//player.give_item(item_type::water_head, 1);
-							//world->game->enter_lobby();
-							world->is_boss_dead = true; // POST-TWEAK: Don't go to lobby immediately.
-							world->boss_item_to_give = item_type::water_head;
-							return;
-						} else if (monster.type == monster_type::final_boss) {
-							// POST-BUGFIX: Fixes bug where player does not go to lobby after final boss.
-							//world->game->enter_lobby();
-							world->is_boss_dead = true; // POST-TWEAK: Don't go to lobby immediately.
-							world->boss_item_to_give = item_type::staff_of_life;
-							return;
-						}
-					}
-					attack.health--;
-					if (attack.health <= 0) {
-						break;
+				//
+				if (!attack.add_hit(monster.id)) {
+					break;
+				}
+				monster.on_being_hit();
+				float damage{ 0.0f };
+				damage -= monster.stats.defense;
+				damage += player_stats.strength;
+				damage += player_stats.bonus_strength;
+				if (damage <= 0.0f) {
+					damage = player_stats.bonus_strength;
+				}
+				const bool critical_hit{ random.chance(player_stats.critical_strike_chance) };
+				if (critical_hit) {
+					damage *= 2.0f;
+				}
+				pending_events.push({ critical_hit ? world_event_type::critical_hit : world_event_type::hit, monster.id, monster.type, true, monster.transform.position });
+				monster.stats.health -= damage;
+				if (monster.stats.health <= 0.0f) {
+					pending_events.push({ world_event_type::kill, monster.id, monster.type, true, monster.transform.position });
+					monster.dead = true;
+					collision_boxes.disable(hit.monster);
+					if (monster.type == monster_type::fire_boss) {
+						//player.give_item(item_type::fire_head, 0);
+						//world->game->enter_lobby();
+						events.boss_item = item_type::fire_head;
+						return;
+					} else if (monster.type == monster_type::water_boss) {
+						//player.give_item(item_type::water_head, 1);
+						//world->game->enter_lobby();
+						events.boss_item = item_type::water_head;
+						return;
+					} else if (monster.type == monster_type::final_boss) {
+						// POST-BUGFIX: Fixes bug where player does not go to lobby after final boss.
+						//world->game->enter_lobby();
+						events.boss_item = item_type::staff_of_life;
+						return;
 					}
 				}
+				attack.health--;
+				if (attack.health <= 0) {
+					break;
+				}
 			}
 		} else {
-			if (player.collision_transform().collides_with(attack.position, attack.size)) {
+			const auto player_collision{ player.collision_transform() };
+			if (swept_overlap_time(attack.position, attack.size, delta, player_collision.position, player_collision.scale) >= 0.0f) {
 				const auto monster_stats{ monster_type::get_stats(attack.type) };
-				player.on_being_hit();
+				events.player_hit = true;
 				float damage{ 0.0f };
 				damage -= player_stats.defense;
 				damage += monster_stats.strength;
@@ -338,11 +386,12 @@ void game_world_room::process_attacks() {
 				if (damage <= 0.0f) {
 					damage = monster_stats.bonus_strength;
 				}
-				if (world->random.chance(monster_stats.critical_strike_chance)) {
+				const bool critical_hit{ random.chance(monster_stats.critical_strike_chance) };
+				if (critical_hit) {
 					damage *= 2.0f;
-					world->game->ui.add_hit_splat(player.id);
 				}
-				player.stats.health -= damage;
+				pending_events.push({ critical_hit ? world_event_type::critical_hit : world_event_type::hit, player.id, attack.type, false, player.transform.position });
+				events.player_damage += damage;
 				//if (player.stats.health <= 0.0f) {
 					//world->game->enter_lobby();
 					//return;
@@ -353,12 +402,17 @@ void game_world_room::process_attacks() {
 				}
 			}
 		}
-		attack.position += attack.speed;
+		attack.position += delta;
+		attack.life_ticks += ticks;
+		if (wall_time) {
+			attack.health = 0;
+		}
 	}
-	for (int i{ 0 }; i < static_cast<int>(attacks.size()); i++) {
-		if (attacks[i].health <= 0 || attacks[i].life_timer.milliseconds() >= attacks[i].max_life_ms) {
-			attacks.erase(attacks.begin() + i);
-			i--;
+	for (int i{ 0 }; i < attacks.size();) {
+		if (attacks[i].is_expired()) {
+			attacks.remove(i);
+		} else {
+			i++;
 		}
 	}
 }
@@ -380,6 +434,23 @@ bool game_world::test_tile_mask(const game_world_room& room, no::vector2f positi
 	return collision.is_solid(uv.x, uv.y, check_x, check_y);
 }
 
+std::optional<float> game_world::find_tile_mask_along(const game_world_room& room, no::vector2f position, no::vector2f delta) const {
+	// The mask is per pixel, so steps must be short enough to not skip over the corners of walls.
+	constexpr float step_length{ 2.0f };
+	const float length{ std::sqrt(delta.x * delta.x + delta.y * delta.y) };
+	if (length == 0.0f) {
+		return std::nullopt;
+	}
+	const int steps{ static_cast<int>(std::ceil(length / step_length)) };
+	for (int i{ 1 }; i <= steps; i++) {
+		const float time{ static_cast<float>(i) / static_cast<float>(steps) };
+		if (test_tile_mask(room, position + delta * time)) {
+			return time;
+		}
+	}
+	return std::nullopt;
+}
+
 bool game_world::is_x_empty(game_world_room* room, no::vector2f position, no::vector2f size, float x_direction, float speed) {
 	if (!room) {
 		room = find_room(position);
@@ -395,15 +466,8 @@ bool game_world::is_x_empty(game_world_room* room, no::vector2f position, no::ve
 	if (test_tile_mask(*room, position)) {
 		return false;
 	}
-	for (auto& monster : room->monsters) {
-		if (!monster.dead && monster.collision_transform().collides_with(position)) {
-			return false;
-		}
-	}
-	for (auto& chest : room->chests) {
-		if (chest.can_collide() && chest.collision_transform().collides_with(position)) {
-			return false;
-		}
+	if (room->is_object_at(position)) {
+		return false;
 	}
 	if (player.collision_transform().collides_with(position)) {
 		return true;
@@ -412,15 +476,8 @@ bool game_world::is_x_empty(game_world_room* room, no::vector2f position, no::ve
 	if (test_tile_mask(*room, position)) {
 		return false;
 	}
-	for (auto& monster : room->monsters) {
-		if (!monster.dead && monster.collision_transform().collides_with(position)) {
-			return false;
-		}
-	}
-	for (auto& chest : room->chests) {
-		if (chest.can_collide() && chest.collision_transform().collides_with(position)) {
-			return false;
-		}
+	if (room->is_object_at(position)) {
+		return false;
 	}
 	if (player.collision_transform().collides_with(position)) {
 		return false;
@@ -443,15 +500,8 @@ bool game_world::is_y_empty(game_world_room* room, no::vector2f position, no::ve
 	if (test_tile_mask(*room, position)) {
 		return false;
 	}
-	for (auto& monster : room->monsters) {
-		if (!monster.dead && monster.collision_transform().collides_with(position)) {
-			return false;
-		}
-	}
-	for (auto& chest : room->chests) {
-		if (chest.can_collide() && chest.collision_transform().collides_with(position)) {
-			return false;
-		}
+	if (room->is_object_at(position)) {
+		return false;
 	}
 	if (player.collision_transform().collides_with(position)) {
 		return false;
@@ -460,15 +510,8 @@ bool game_world::is_y_empty(game_world_room* room, no::vector2f position, no::ve
 	if (test_tile_mask(*room, position)) {
 		return false;
 	}
-	for (auto& monster : room->monsters) {
-		if (!monster.dead && monster.collision_transform().collides_with(position)) {
-			return false;
-		}
-	}
-	for (auto& chest : room->chests) {
-		if (chest.can_collide() && chest.collision_transform().collides_with(position)) {
-			return false;
-		}
+	if (room->is_object_at(position)) {
+		return false;
 	}
 	if (player.collision_transform().collides_with(position)) {
 		return false;
@@ -477,6 +520,7 @@ bool game_world::is_y_empty(game_world_room* room, no::vector2f position, no::ve
 }
 
 no::vector2f game_world::get_allowed_movement_delta(game_world_room* room, bool left, bool right, bool up, bool down, float speed, no::vector2f position, no::vector2f size) {
+	PROFILE_ZONE("game_world::get_allowed_movement_delta");
 	if (left && right && up && down) {
 		return {};
 	}
@@ -647,6 +691,82 @@ bool game_world_room::is_position_within(no::vector2f position) const {
 	return position_index >= index && index.x + width() > position_index.x && index.y + height() > position_index.y;
 }
 
+bool game_world_room::is_walkable(int x, int y) const {
+	return x >= 0 && y >= 0 && x < width() && y < height() && tile_at(x, y).is_only(tile_type::floor);
+}
+
+void game_world_room::update_flow_field() {
+	const auto player_collision{ world->player.collision_transform() };
+	const no::vector2f player_center{ player_collision.position + player_collision.scale / 2.0f };
+	const no::vector2i target{ player_center.to<int>() / tile_size - index };
+	if (target == flow_target && static_cast<int>(flow_direction.size()) == width() * height()) {
+		return;
+	}
+	flow_target = target;
+	const int tile_count{ width() * height() };
+	flow_distance.assign(tile_count, unreachable);
+	flow_direction.assign(tile_count, no_flow);
+	flow_queue.clear();
+	flow_queue.reserve(tile_count);
+	if (target.x < 0 || target.y < 0 || target.x >= width() || target.y >= height()) {
+		return;
+	}
+	flow_distance[make_index(target.x, target.y)] = 0;
+	flow_queue.push_back(make_index(target.x, target.y));
+	for (int i{ 0 }; i < static_cast<int>(flow_queue.size()); i++) {
+		const int current{ flow_queue[i] };
+		const int x{ current % width() };
+		const int y{ current / width() };
+		for (int d{ 0 }; d < 4; d++) {
+			const int next_x{ x + flow_offsets[d].x };
+			const int next_y{ y + flow_offsets[d].y };
+			if (!is_walkable(next_x, next_y)) {
+				continue;
+			}
+			auto& distance{ flow_distance[make_index(next_x, next_y)] };
+			if (distance == unreachable) {
+				distance = flow_distance[current] + 1;
+				flow_queue.push_back(make_index(next_x, next_y));
+			}
+		}
+	}
+	// Every tile points at its closest neighbour, including walls that monsters partially overlap.
+	// Diagonal steps are only taken when both tiles beside them are walkable, so corners aren't cut.
+	for (int y{ 0 }; y < height(); y++) {
+		for (int x{ 0 }; x < width(); x++) {
+			const int current{ make_index(x, y) };
+			unsigned short best{ flow_distance[current] };
+			for (int d{ 0 }; d < 8; d++) {
+				const no::vector2i offset{ flow_offsets[d] };
+				if (!is_walkable(x + offset.x, y + offset.y)) {
+					continue;
+				}
+				if (d >= 4 && (!is_walkable(x + offset.x, y) || !is_walkable(x, y + offset.y))) {
+					continue;
+				}
+				const unsigned short distance{ flow_distance[make_index(x + offset.x, y + offset.y)] };
+				if (distance < best) {
+					best = distance;
+					flow_direction[current] = static_cast<unsigned char>(d);
+				}
+			}
+		}
+	}
+}
+
+no::vector2i game_world_room::flow_direction_at(no::vector2f position) const {
+	// The field is only kept up to date while the player is in the room. Elsewhere it points at where they left.
+	if (world->player.room != this) {
+		return 0;
+	}
+	const no::vector2i tile{ position.to<int>() / tile_size - index };
+	if (tile.x < 0 || tile.y < 0 || tile.x >= width() || tile.y >= height() || flow_direction.empty()) {
+		return 0;
+	}
+	const unsigned char direction{ flow_direction[make_index(tile.x, tile.y)] };
+	return direction == no_flow ? no::vector2i{ 0 } : flow_offsets[direction];
+}
+
 bool game_world_room::is_connected_to(const game_world_room& room) const {
 	for (const auto& door : doors) {
 		if (door.to_room == &room) {
@@ -657,69 +777,206 @@ bool game_world_room::is_connected_to(const game_world_room& room) const {
 }
 
 game_world_room::door_connection* game_world_room::find_colliding_door(no::vector2f position, no::vector2f size) {
-	for (auto& door : doors) {
-		no::transform2 transform;
-		transform.position = { door.from_tile.to<float>() * tile_size_f + index.to<float>() * tile_size_f };
-		transform.scale = tile_size_f;
-		if (transform.collides_with(position, size)) {
-			return &door;
+	const int door_index{ door_boxes.first_overlap(position, size) };
+	return door_index != -1 ? &doors[door_index] : nullptr;
+}
+
+void game_world_room::find_swept_hits(const active_attack& attack, no::vector2f delta) {
+	swept_hits.clear();
+	// Narrow down to the monsters near the path, then find when the attack touches each of them.
+	const no::vector2f swept_position{ std::min(attack.position.x, attack.position.x + delta.x), std::min(attack.position.y, attack.position.y + delta.y) };
+	const no::vector2f swept_size{ attack.size.x + std::abs(delta.x), attack.size.y + std::abs(delta.y) };
+	if (collision_boxes.overlaps(swept_position, swept_size, hit_mask) == 0) {
+		return;
+	}
+	// The monsters' boxes come first, in the same order, and those of dead monsters are disabled.
+	for (int i{ 0 }; i < static_cast<int>(monsters.size()); i++) {
+		if ((hit_mask[i / 32] & (1u << (i % 32))) == 0) {
+			continue;
+		}
+		const auto collision{ monsters[i].collision_transform() };
+		const float time{ swept_overlap_time(attack.position, attack.size, delta, collision.position, collision.scale) };
+		if (time >= 0.0f) {
+			swept_hits.push_back({ time, i });
 		}
 	}
-	return nullptr;
+	std::stable_sort(swept_hits.begin(), swept_hits.end(), [](const swept_hit& a, const swept_hit& b) {
+		return a.time < b.time;
+	});
 }
 
-std::optional<no::vector2f> game_world_room::find_empty_position() const {
-	for (int attempt{ 0 }; attempt < 100; attempt++) {
-		const int x{ world->random.next<int>(2, width() - 2) };
-		const int y{ world->random.next<int>(2, height() - 2) };
-		if (!tile_at(x, y).is_only(tile_type::floor)) {
-			continue;
-		} else if (!tile_at(x + 1, y).is_only(tile_type::floor)) {
-			continue;
-		} else if (!tile_at(x, y + 1).is_only(tile_type::floor)) {
-			continue;
-		} else if (!tile_at(x - 1, y).is_only(tile_type::floor)) {
-			continue;
-		} else if (!tile_at(x, y - 1).is_only(tile_type::floor)) {
-			continue;
+void game_world_room::refresh_collision_boxes() {
+	collision_boxes.clear();
+	for (const auto& monster : monsters) {
+		const auto collision{ monster.collision_transform() };
+		const int box{ collision_boxes.add(collision.position, collision.scale) };
+		if (monster.dead) {
+			collision_boxes.disable(box);
 		}
-		const no::vector2f position{
-			static_cast<float>(x * tile_size + index.x * tile_size),
-			static_cast<float>(y * tile_size + index.y * tile_size)
-		};
-		bool next{ false };
-		for (const auto& chest : chests) {
-			// POST-BUGFIX: Change distance
-			if (chest.collision_transform().position.distance_to(position) < chest.collision_transform().scale.x * 1.2f) {
-				next = true;
-				break;
+	}
+	for (const auto& chest : chests) {
+		const auto collision{ chest.collision_transform() };
+		const int box{ collision_boxes.add(collision.position, collision.scale) };
+		if (!chest.can_collide()) {
+			collision_boxes.disable(box);
+		}
+	}
+}
+
+void game_world_room::update_collision_box(const monster_object& monster) {
+	const int box{ static_cast<int>(&monster - monsters.data()) };
+	if (monster.dead) {
+		collision_boxes.disable(box);
+	} else {
+		const auto collision{ monster.collision_transform() };
+		collision_boxes.set(box, collision.position, collision.scale);
+	}
+}
+
+void game_world_room::update_collision_box(const chest_object& chest) {
+	const int box{ static_cast<int>(monsters.size() + (&chest - chests.data())) };
+	if (chest.can_collide()) {
+		const auto collision{ chest.collision_transform() };
+		collision_boxes.set(box, collision.position, collision.scale);
+	} else {
+		collision_boxes.disable(box);
+	}
+}
+
+bool game_world_room::is_object_at(no::vector2f position) const {
+	return collision_boxes.first_overlap(position, 0.0f) != -1;
+}
+
+void game_world_room::build_spawn_tiles() {
+	// Breadth-first search outwards from every tile that isn't only floor.
+	constexpr unsigned char unknown{ 0xFF };
+	const no::vector2i steps[4]{ { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+	wall_distance.assign(width() * height(), unknown);
+	std::vector<int> queue;
+	queue.reserve(width() * height());
+	for (int y{ 0 }; y < height(); y++) {
+		for (int x{ 0 }; x < width(); x++) {
+			if (!tile_at(x, y).is_only(tile_type::floor)) {
+				wall_distance[make_index(x, y)] = 0;
+				queue.push_back(make_index(x, y));
+			}
+		}
+	}
+	for (int i{ 0 }; i < static_cast<int>(queue.size()); i++) {
+		const int x{ queue[i] % width() };
+		const int y{ queue[i] / width() };
+		const int distance{ wall_distance[queue[i]] };
+		for (const auto& step : steps) {
+			const int next_x{ x + step.x };
+			const int next_y{ y + step.y };
+			if (next_x < 0 || next_y < 0 || next_x >= width() || next_y >= height()) {
+				continue;
+			}
+			auto& next_distance{ wall_distance[make_index(next_x, next_y)] };
+			if (next_distance == unknown) {
+				next_distance = static_cast<unsigned char>(std::min(distance + 1, unknown - 1));
+				queue.push_back(make_index(next_x, next_y));
 			}
 		}
-		if (!next) {
-			return position;
+	}
+	// Two steps means the tile and its four neighbours are floor, which is what spawning used to check for.
+	spawn_tiles.clear();
+	for (int y{ 0 }; y < height(); y++) {
+		for (int x{ 0 }; x < width(); x++) {
+			if (wall_distance_at(x, y) >= 2) {
+				spawn_tiles.emplace_back(x, y);
+			}
 		}
 	}
-	return {};
 }
 
-game_object* game_world_room::object_with_id(int id) const {
-	if (world->player.id == id) {
-		return &world->player;
+int game_world_room::wall_distance_at(int x, int y) const {
+	if (x < 0 || y < 0 || x >= width() || y >= height() || wall_distance.empty()) {
+		return 0;
 	}
-	for (auto& monster : monsters) {
-		if (monster.id == id) {
-			return (game_object*)&monster;
+	return wall_distance[make_index(x, y)];
+}
+
+void game_world_room::remove_spawn_tiles_near(const chest_object& chest) {
+	const auto chest_collision{ chest.collision_transform() };
+	for (int i{ 0 }; i < static_cast<int>(spawn_tiles.size()); i++) {
+		const no::vector2f position{ ((index + spawn_tiles[i]) * tile_size).to<float>() };
+		// POST-BUGFIX: Change distance
+		if (chest_collision.position.distance_to(position) < chest_collision.scale.x * 1.2f) {
+			spawn_tiles[i] = spawn_tiles.back();
+			spawn_tiles.pop_back();
+			i--;
 		}
 	}
-	for (auto& chest : chests) {
-		if (chest.id == id) {
-			return (game_object*)&chest;
-		}
+}
+
+std::optional<no::vector2f> game_world_room::find_empty_position() const {
+	if (spawn_tiles.empty()) {
+		return {};
 	}
-	return nullptr;
+	// Tiles next to chests are removed as the chests are placed, so any spawn tile will do.
+	const auto tile{ spawn_tiles[world->random.next<int>(0, static_cast<int>(spawn_tiles.size()) - 1)] };
+	return ((index + tile) * tile_size).to<float>();
+}
+
+game_object* game_world_room::object_with_id(int id) const {
+	auto object{ world->find_object(id) };
+	if (object && object != &world->player && object->room != this) {
+		return nullptr;
+	}
+	return object;
+}
+
+void game_object_index::reset(int new_first_id) {
+	slots.clear();
+	first_id = new_first_id;
+	generation++;
+}
+
+void game_object_index::set(game_object& object) {
+	if (object.id < first_id) {
+		return;
+	}
+	const int index{ object.id - first_id };
+	if (index >= static_cast<int>(slots.size())) {
+		slots.resize(index + 1);
+	}
+	slots[index].object = &object;
+	slots[index].generation = generation;
+}
+
+void game_object_index::remove(int id) {
+	if (auto slot{ const_cast<game_object_index::slot*>(find_slot(id)) }) {
+		slot->object = nullptr;
+		slot->generation = -1;
+	}
+}
+
+game_object* game_object_index::find(int id) const {
+	const auto slot{ find_slot(id) };
+	return slot ? slot->object : nullptr;
+}
+
+game_object* game_object_index::find(object_handle handle) const {
+	const auto slot{ find_slot(handle.id) };
+	return slot && slot->generation == handle.generation ? slot->object : nullptr;
+}
+
+object_handle game_object_index::handle(int id) const {
+	const auto slot{ find_slot(id) };
+	return { id, slot ? slot->generation : -1 };
 }
 
-game_world::game_world() {
+const game_object_index::slot* game_object_index::find_slot(int id) const {
+	const int index{ id - first_id };
+	if (index < 0 || index >= static_cast<int>(slots.size())) {
+		return nullptr;
+	}
+	return &slots[index];
+}
+
+game_world::game_world() : rooms{ arena.resource() } {
+	rooms.reserve(max_rooms);
 	const no::surface mask{ no::asset_path("textures/collisions.png") };
 	collision.width = mask.width();
 	collision.mask.reserve(mask.count());
@@ -733,6 +990,7 @@ game_world::game_world() {
 }
 
 void game_world::update() {
+	PROFILE_ZONE("game_world::update");
 	// POST-TWEAK
 	if (player.stats.health <= 0.0f) {
 		if (!player.animation.is_done()) {
@@ -742,7 +1000,9 @@ void game_world::update() {
 		}
 		if (player.last_animation == animation_type::die) {
 			if (player.animation.is_done()) {
-				game->enter_lobby();
+				if (game) {
+					game->enter_lobby();
+				}
 			} else {
 				player.animation.update(1.0f / 60.0f);
 			}
@@ -751,13 +1011,77 @@ void game_world::update() {
 	}
 	//
 	player.update();
-	if (!player.room || game->show_all_rooms) {
+	if (!player.room || (game && game->show_all_rooms)) {
+		jobs.parallel_for(static_cast<int>(rooms.size()), [this](int index) {
+			rooms[index].update();
+		});
 		for (auto& room : rooms) {
-			room.update();
+			room.finish_update();
+			room.tier = simulation_tier::full;
+			room.pending_ticks = 0;
 		}
-	} else if (player.room) {
+	} else if (simulation_lod) {
+		update_rooms_by_tier();
+	} else {
 		player.room->update();
+		player.room->finish_update();
+	}
+}
+
+void game_world::update_rooms_by_tier() {
+	auto& current_room{ *player.room };
+	rooms_to_update.clear();
+	for (int i{ 0 }; i < static_cast<int>(rooms.size()); i++) {
+		auto& room{ rooms[i] };
+		room.pending_ticks = std::min(room.pending_ticks + 1, max_catch_up_ticks);
+		if (&room == &current_room) {
+			room.tier = simulation_tier::full;
+		} else if (current_room.is_connected_to(room)) {
+			room.tier = simulation_tier::reduced;
+		} else {
+			room.tier = simulation_tier::dormant;
+		}
+		if (room.tier == simulation_tier::reduced && room.pending_ticks >= reduced_tick_interval) {
+			rooms_to_update.push_back(i);
+		}
+	}
+	// The player just entered a room that was behind. Catch up in coarse steps before the regular tick,
+	// without the player, since they weren't there for it. Monsters only wander, so they don't close in on the door.
+	current_room.catching_up = true;
+	while (current_room.pending_ticks > 1) {
+		const int ticks{ std::min(current_room.pending_ticks - 1, reduced_tick_interval) };
+		current_room.update(ticks);
+		current_room.events.player_hit = false;
+		current_room.events.player_damage = 0.0f;
+		current_room.finish_update();
+		current_room.pending_ticks -= ticks;
+	}
+	current_room.catching_up = false;
+	rooms_to_update.push_back(static_cast<int>(&current_room - rooms.data()));
+	std::sort(rooms_to_update.begin(), rooms_to_update.end());
+	// Monster movement is only checked for collision at the end of each step, so a long backlog is split into short steps.
+	jobs.parallel_for(static_cast<int>(rooms_to_update.size()), [this](int index) {
+		auto& room{ rooms[rooms_to_update[index]] };
+		for (int remaining{ room.pending_ticks }; remaining > 0;) {
+			const int ticks{ std::min(remaining, reduced_tick_interval) };
+			room.update(ticks);
+			remaining -= ticks;
+		}
+	});
+	for (const int index : rooms_to_update) {
+		rooms[index].finish_update();
+		rooms[index].pending_ticks = 0;
+	}
+}
+
+int game_world::rooms_in_tier(int tier) const {
+	int count{ 0 };
+	for (const auto& room : rooms) {
+		if (room.tier == tier) {
+			count++;
+		}
 	}
+	return count;
 }
 
 void game_world::add_monsters() {
@@ -766,6 +1090,72 @@ void game_world::add_monsters() {
 	}
 }
 
+void game_world::place_player() {
+	for (auto& room : rooms) {
+		if (const auto position{ room.find_empty_position() }) {
+			player.transform.position = position.value();
+			return;
+		}
+	}
+}
+
 int game_world::next_object_id() {
 	return object_id_counter++;
 }
+
+monster_object& game_world::spawn_monster(game_world_room& room, int type) {
+	auto& monster{ room.monsters.emplace_back(type) };
+	monster.id = next_object_id();
+	monster.world = this;
+	monster.room = &room;
+	return monster;
+}
+
+void game_world::remove_monster(const monster_object& monster) {
+	object_index.remove(monster.id);
+}
+
+void game_world::clear_rooms() {
+	{
+		// The vector's own buffer is in the arena too, so it has to be gone before the arena is reset.
+		std::pmr::vector<game_world_room> old_rooms{ arena.resource() };
+		old_rooms.swap(rooms);
+	}
+	arena.reset();
+	rooms.reserve(max_rooms);
+	events.clear();
+	player.room = nullptr;
+	object_index.reset(object_id_counter);
+}
+
+void game_world::index_room_objects(game_world_room& room) {
+	// Called after the room's containers may have moved their elements.
+	for (auto& monster : room.monsters) {
+		object_index.set(monster);
+	}
+	for (auto& chest : room.chests) {
+		object_index.set(chest);
+	}
+	room.refresh_collision_boxes();
+}
+
+game_object* game_world::find_object(int id) const {
+	if (id == player.id) {
+		return const_cast<player_object*>(&player);
+	}
+	return object_index.find(id);
+}
+
+game_object* game_world::find_object(object_handle handle) const {
+	if (handle.id == player.id) {
+		return const_cast<player_object*>(&player);
+	}
+	return object_index.find(handle);
+}
+
+object_handle game_world::handle_of(int id) const {
+	if (id == player.id) {
+		return { id, 0 };
+	}
+	return object_index.handle(id);
+}
@@ -3,13 +3,26 @@
 #include "player.hpp"
 #include "monster.hpp"
 #include "autotile.hpp"
+#include "arena.hpp"
+#include "job_system.hpp"
+#include "collision_batch.hpp"
+#include "world_events.hpp"
 #include "math.hpp"
 
+#include <array>
 #include <optional>
 
 class game_world;
 class game_state;
 
+constexpr int ticks_per_second{ 60 };
+
+// How often rooms are simulated, decided each tick from where the player is.
+namespace simulation_tier {
+constexpr int full{ 0 }; // the player's room, every tick
+constexpr int reduced{ 1 }; // rooms with a door to the player's room, every few ticks
+constexpr int dormant{ 2 }; // not simulated, but catches up when the player enters
+}
 constexpr int tile_size{ 32 };
 constexpr float tile_size_f{ 32.0f };
 
@@ -80,36 +93,152 @@ public:
 	};
 
 	struct active_attack {
+
+		static constexpr int max_hits{ 8 };
+
 		int type{ 0 }; // weapon_type if player, and monster_type if not
-		int max_life_ms{ 0 };
-		no::timer life_timer;
+		int life_ticks{ 0 };
+		int max_life_ticks{ 0 };
 		no::vector2f origin;
 		no::vector2f position;
 		no::vector2f size;
 		no::vector2f speed;
 		bool by_player{ false };
 		int health{ 0 };
-		std::vector<int> hits; // POST-BUGFIX: Don't hit same enemy twice with same attack.
+
+		// POST-BUGFIX: Don't hit same enemy twice with same attack.
+		int hits[max_hits]{};
+		int hit_count{ 0 };
+
+		bool has_hit(int id) const {
+			for (int i{ 0 }; i < hit_count; i++) {
+				if (hits[i] == id) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Returns false when the list is full. The attack can't tell who it has hit beyond that, so it must not hit anyone new.
+		bool add_hit(int id) {
+			if (hit_count == max_hits) {
+				return false;
+			}
+			hits[hit_count] = id;
+			hit_count++;
+			return true;
+		}
+
+		bool is_expired() const {
+			return health <= 0 || life_ticks >= max_life_ticks;
+		}
+
+	};
+
+	// Fixed capacity storage for the attacks in a room. Removal swaps in the last attack, so order is not kept.
+	class active_attack_pool {
+	public:
+
+		static constexpr int capacity{ 256 };
+
+		active_attack* add() {
+			if (count == capacity) {
+				dropped++;
+				return nullptr;
+			}
+			attacks[count] = {};
+			count++;
+			peak = std::max(peak, count);
+			return &attacks[count - 1];
+		}
+
+		void remove(int index) {
+			count--;
+			if (index < count) {
+				attacks[index] = attacks[count];
+			}
+		}
+
+		active_attack& operator[](int index) {
+			return attacks[index];
+		}
+
+		active_attack* begin() {
+			return attacks.data();
+		}
+
+		active_attack* end() {
+			return attacks.data() + count;
+		}
+
+		const active_attack* begin() const {
+			return attacks.data();
+		}
+
+		const active_attack* end() const {
+			return attacks.data() + count;
+		}
+
+		int size() const {
+			return count;
+		}
+
+		int peak_size() const {
+			return peak;
+		}
+
+		// Attacks that could not be added because the pool was full.
+		long long dropped_count() const {
+			return dropped;
+		}
+
+	private:
+
+		std::array<active_attack, capacity> attacks;
+		int count{ 0 };
+		int peak{ 0 };
+		long long dropped{ 0 };
+
+	};
+
+	// What a room's update does to the rest of the world. Rooms may update in parallel,
+	// so this is collected per room and applied in room order by game_world_room::finish_update().
+	struct tick_events {
+		float player_damage{ 0.0f };
+		bool player_hit{ false };
+		int boss_item{ -1 }; // set when a boss was killed
 	};
 
 	game_world* world{ nullptr };
+	no::random_number_generator random; // seeded from the world's, so rooms can update in any order
+	tick_events events;
+	world_event_queue pending_events; // moved to the world's queue by finish_update()
 	no::vector2i index;
-	std::vector<door_connection> doors;
-	std::vector<monster_object> monsters;
-	std::vector<active_attack> attacks;
-	std::vector<chest_object> chests;
+	std::pmr::vector<door_connection> doors;
+	std::pmr::vector<monster_object> monsters;
+	active_attack_pool attacks;
+	std::pmr::vector<chest_object> chests;
 	bool initial_monsters_spawned{ false };
 	char type{ 'f' }; // f = fire, w = water, l = light
 	bool is_boss_room{ false };
+	int tier{ simulation_tier::full };
+	int pending_ticks{ 0 }; // ticks passed since the room was last updated
+	bool catching_up{ false }; // while simulating ticks the player wasn't there for, monsters don't chase or attack
+
+	// The monsters' collision boxes in the same order as the monsters, followed by the chests'.
+	// Dead monsters and chests that can't be collided with are disabled.
+	aabb_batch collision_boxes;
 
 	void add_door(no::vector2i from, game_world_room* room, no::vector2i to) {
 		auto& door{ doors.emplace_back() };
 		door.from_tile = from;
 		door.to_room = room;
 		door.to_tile = to;
+		door_boxes.add(from.to<float>() * tile_size_f + index.to<float>() * tile_size_f, tile_size_f);
 	}
 	
-	game_world_room() = default;
+	// Containers are allocated from the world's dungeon arena.
+	game_world_room(game_world& world);
 	game_world_room(const game_world_room&) = delete;
 	game_world_room(game_world_room&&) noexcept;
 
@@ -120,8 +249,13 @@ public:
 
 	int next_monster_type();
 
-	void update();
+	// Only touches this room and reads the player, so rooms can be updated on separate threads.
+	// Ticks above 1 are used for rooms simulated at a lower rate, and trade collision accuracy for speed.
+	void update(int ticks = 1);
+	// Must be called on the main thread after update(), in room order.
+	void finish_update();
 	void add_monsters();
+	void reap_dead_monsters();
 
 	void set_tile(int x, int y, game_world_tile tile);
 	game_world_tile tile_at(int x, int y) const;
@@ -138,21 +272,61 @@ public:
 	int make_index(int x, int y) const;
 
 	void spawn_attack(bool by_player, int type, int attack_health, no::vector2f position, no::vector2f size, no::vector2f speed, int max_life_ms);
-	void process_attacks();
+	void process_attacks(int ticks = 1);
 
 	bool is_tile_colliding_with(no::vector2f position) const;
 	bool is_position_within(no::vector2f position) const;
 	bool is_connected_to(const game_world_room& room) const;
 	door_connection* find_colliding_door(no::vector2f position, no::vector2f size);
 
+	// Must be called when monsters or chests are added, removed or reordered.
+	void refresh_collision_boxes();
+	void update_collision_box(const monster_object& monster);
+	void update_collision_box(const chest_object& chest);
+	bool is_object_at(no::vector2f position) const;
+
+	// Must be called once the tiles are final. Finds the tiles monsters, chests and the player can spawn on.
+	void build_spawn_tiles();
+	// Number of tiles to the nearest tile that is not only floor, counting orthogonal steps.
+	int wall_distance_at(int x, int y) const;
+
+	// Takes the tiles too close to the chest out of the spawn tiles.
+	void remove_spawn_tiles_near(const chest_object& chest);
 	std::optional<no::vector2f> find_empty_position() const;
 
 	game_object* object_with_id(int id) const;
 
+	// Step towards the player along walkable tiles from the tile at the position, or zero if there is no path.
+	// Zero in rooms the player isn't in, since the field is only kept up to date for the player's room.
+	no::vector2i flow_direction_at(no::vector2f position) const;
+
 private:
 
-	std::vector<game_world_tile> tiles;
+	struct swept_hit {
+		float time{ 0.0f };
+		int monster{ 0 };
+	};
+
+	// Breadth-first search from the player's tile, redone only when the player moves to another tile.
+	void update_flow_field();
+	bool is_walkable(int x, int y) const;
+
+	// Sorted by time, so an attack hits monsters in the order it reaches them.
+	void find_swept_hits(const active_attack& attack, no::vector2f delta);
+
+	std::pmr::vector<game_world_tile> tiles;
 	no::vector2i size;
+	aabb_batch door_boxes; // in the same order as the doors
+	std::vector<uint32_t> hit_mask; // reused by process_attacks
+	std::vector<swept_hit> swept_hits; // reused by process_attacks
+
+	std::pmr::vector<unsigned char> wall_distance;
+	std::pmr::vector<no::vector2i> spawn_tiles; // at least two steps from any wall
+
+	no::vector2i flow_target{ -1 };
+	std::pmr::vector<unsigned short> flow_distance;
+	std::pmr::vector<unsigned char> flow_direction; // index into flow_offsets, or no_flow
+	std::pmr::vector<int> flow_queue;
 
 };
 
@@ -174,14 +348,56 @@ public:
 
 };
 
+// Refers to an object by id. Resolving a handle to an object that is gone yields nullptr.
+struct object_handle {
+	int id{ -1 };
+	int generation{ -1 };
+};
+
+// Dense id -> object lookup. Ids are handed out in increasing order by game_world::next_object_id,
+// so the slots are a plain array offset by the first id of the current dungeon.
+class game_object_index {
+public:
+
+	void reset(int first_id);
+	void set(game_object& object);
+	void remove(int id);
+
+	game_object* find(int id) const;
+	game_object* find(object_handle handle) const;
+	object_handle handle(int id) const;
+
+private:
+
+	struct slot {
+		game_object* object{ nullptr };
+		int generation{ -1 };
+	};
+
+	const slot* find_slot(int id) const;
+
+	std::vector<slot> slots;
+	int first_id{ 0 };
+	int generation{ 0 };
+
+};
+
 class game_world {
 public:
 
+	static constexpr int max_rooms{ 16 };
+	static constexpr int reduced_tick_interval{ 4 };
+	static constexpr int max_catch_up_ticks{ ticks_per_second * 2 };
+
 	world_autotiler autotiler;
 	player_object player;
-	std::vector<game_world_room> rooms;
-	game_state* game{ nullptr };
+	dungeon_arena arena; // must outlive rooms
+	std::pmr::vector<game_world_room> rooms;
+	game_state* game{ nullptr }; // null in the batch runs that simulate the world without the game
 	no::random_number_generator random;
+	job_system jobs;
+	world_event_queue events; // handled and cleared by the game once per frame
+	bool simulation_lod{ false }; // neighbour rooms keep moving while the player is away. Opt in from the debug menu for now.
 	bool is_lobby{ false };
 
 	// POST-TWEAK: Don't teleport to lobby directly after killing boss.
@@ -193,8 +409,14 @@ public:
 
 	void update();
 	void add_monsters();
+	int rooms_in_tier(int tier) const;
+
+	// Moves the player to the first empty position, starting from the first room.
+	void place_player();
 
 	bool test_tile_mask(const game_world_room& room, no::vector2f position) const;
+	// Fraction of the delta at which the tile mask is first solid, when moving from the position.
+	std::optional<float> find_tile_mask_along(const game_world_room& room, no::vector2f position, no::vector2f delta) const;
 
 	bool is_x_empty(game_world_room* room, no::vector2f position, no::vector2f size, float x_direction, float speed);
 	bool is_y_empty(game_world_room* room, no::vector2f position, no::vector2f size, float y_direction, float speed);
@@ -209,9 +431,23 @@ public:
 
 	int next_object_id();
 
+	monster_object& spawn_monster(game_world_room& room, int type);
+	// Must be called before a reaped monster is erased from its room.
+	void remove_monster(const monster_object& monster);
+
+	void clear_rooms();
+	void index_room_objects(game_world_room& room);
+	game_object* find_object(int id) const;
+	game_object* find_object(object_handle handle) const;
+	object_handle handle_of(int id) const;
+
 private:
+
+	void update_rooms_by_tier();
 	
 	tileset_collision_mask collision;
 	int object_id_counter{ 0 };
+	game_object_index object_index;
+	std::vector<int> rooms_to_update;
 
 };
@@ -0,0 +1,53 @@
+#include "world_events.hpp"
+
+namespace world_event_type {
+
+const char* get_name(int type) {
+	switch (type) {
+	case hit: return "Hit";
+	case critical_hit: return "Critical hit";
+	case kill: return "Kill";
+	case boss_death: return "Boss death";
+	case boss_reward: return "Boss reward";
+	case room_change: return "Room change";
+	case attack_spawn: return "Attack spawn";
+	default: return "";
+	}
+}
+
+}
+
+void world_event_queue::push(const world_event& event) {
+	events.push_back(event);
+	counts[event.type]++;
+}
+
+void world_event_queue::append(const world_event_queue& that) {
+	events.insert(events.end(), that.events.begin(), that.events.end());
+	for (int type{ 0 }; type < world_event_type::total_types; type++) {
+		counts[type] += that.counts[type];
+	}
+}
+
+void world_event_queue::clear() {
+	events.clear();
+	for (auto& count : counts) {
+		count = 0;
+	}
+}
+
+const world_event* world_event_queue::begin() const {
+	return events.data();
+}
+
+const world_event* world_event_queue::end() const {
+	return events.data() + events.size();
+}
+
+int world_event_queue::size() const {
+	return static_cast<int>(events.size());
+}
+
+int world_event_queue::count(int type) const {
+	return counts[type];
+}
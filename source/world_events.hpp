@@ -0,0 +1,46 @@
+#pragma once
+
+#include "math.hpp"
+
+#include <vector>
+
+namespace world_event_type {
+constexpr int hit{ 0 };
+constexpr int critical_hit{ 1 };
+constexpr int kill{ 2 };
+constexpr int boss_death{ 3 };
+constexpr int boss_reward{ 4 }; // every tick from when a boss' death animation ends
+constexpr int room_change{ 5 };
+constexpr int attack_spawn{ 6 };
+constexpr int total_types{ 7 };
+
+const char* get_name(int type);
+}
+
+struct world_event {
+	int type{ world_event_type::hit };
+	int object_id{ -1 }; // the object that was hit, killed or changed room
+	int value{ 0 }; // monster type for kills, item for bosses, room type for room changes, weapon or monster type for attacks
+	bool by_player{ false };
+	no::vector2f position;
+};
+
+// What the simulation wants presented, collected during the update and handled by the game once per frame.
+class world_event_queue {
+public:
+
+	void push(const world_event& event);
+	void append(const world_event_queue& that);
+	void clear();
+
+	const world_event* begin() const;
+	const world_event* end() const;
+	int size() const;
+	int count(int type) const;
+
+private:
+
+	std::vector<world_event> events;
+	int counts[world_event_type::total_types]{};
+
+};